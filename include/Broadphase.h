@@ -0,0 +1,97 @@
+#ifndef BROADPHASE_H
+#define BROADPHASE_H
+
+#include "NarrowPhase.h"
+#include "ParticleStore.h"
+#include "WorkerPool.h"
+
+#include <algorithm>
+#include <functional>
+#include <vector>
+
+enum class BroadphaseKind
+{
+    Grid,       // uniform grid levels, see GridBroadphase
+    Sweep,      // sort and sweep along one axis, see SweepBroadphase
+    Hash,       // uniform grid storing only occupied cells, see HashBroadphase
+    Count
+};
+
+/// <summary>
+/// Resolves one batch of candidates: each of the first <c>owners</c> lanes is tested against every
+/// lane after it. Called with the index of the calling worker, from several workers at once.
+/// </summary>
+using BatchResolver = std::function<void(int, CandidateBatch&, int)>;
+
+/// <summary>
+/// Called with the indices of two objects that may be touching.
+/// </summary>
+using PairVisitor = std::function<void(int, int)>;
+
+/// <summary>
+/// Finds the objects that may be touching. An implementation is told the radius range the objects are
+/// drawn from through <c>setRadiusRange</c>, which may size its cells, and brings its structure up to date with
+/// the objects' positions in <c>update</c>, then hands every group of nearby objects to a resolver
+/// in <c>collide</c>, scheduling the groups on the worker pool so that groups running at the same
+/// time never share an object. The schedule must not depend on the thread count. Serial passes that
+/// need the same neighbourhoods, such as finding contact islands, use <c>forEachNearPair</c>.
+/// </summary>
+class Broadphase
+{
+protected:
+    // per-worker batch, padded so workers never share a cache line
+    struct alignas(64) ThreadBatch
+    {
+        CandidateBatch batch;
+    };
+
+    std::vector<ThreadBatch> threadBatches;
+
+    /// <summary>
+    /// Makes sure every worker of the pool has a batch to fill.
+    /// </summary>
+    void prepareBatches(const WorkerPool& workers)
+    {
+        if (int(threadBatches.size()) < workers.getThreadCount()) threadBatches.resize(workers.getThreadCount());
+    }
+
+    /// <summary>
+    /// Splits a run of independent items into one contiguous range per worker, each holding about the
+    /// same share of the estimated work rather than the same number of items.
+    /// </summary>
+    /// <param name="workPrefix">Running total of the work, <c>workPrefix[k]</c> covering the items before k.</param>
+    /// <param name="thread">The worker asking for its range.</param>
+    /// <param name="threadCount"></param>
+    /// <param name="first">Set to the first item of the worker's range.</param>
+    /// <param name="last">Set to one past the last item of the worker's range.</param>
+    static void splitByWork(const std::vector<long long>& workPrefix, int thread, int threadCount, int& first, int& last)
+    {
+        int itemCount = int(workPrefix.size()) - 1;
+        auto boundary = [&](int t) {
+            if (t >= threadCount) return itemCount;
+            // the item boundary nearest to t shares of the total
+            long long share = workPrefix.back() * t / threadCount;
+            int k = int(std::lower_bound(workPrefix.begin(), workPrefix.end(), share) - workPrefix.begin());
+            if (k > 0 && share - workPrefix[k - 1] < workPrefix[k] - share) k--;
+            return k;
+        };
+        first = boundary(thread);
+        last = boundary(thread + 1);
+    }
+
+public:
+    virtual ~Broadphase() {}
+
+    virtual const char* getName() const = 0;
+    virtual void setRadiusRange(int, int) = 0;
+    virtual void update(const ParticleStore&) = 0;
+    virtual void collide(const ParticleStore&, WorkerPool&, const BatchResolver&) = 0;
+    virtual void forEachNearPair(const ParticleStore&, float, const PairVisitor&) = 0;
+    virtual void reset() = 0;
+
+    virtual float getMigrationFraction() const = 0;
+    virtual float getDisorder() const = 0;
+    virtual void getTraversalOrder(std::vector<int>&) const = 0;
+};
+
+#endif
@@ -0,0 +1,168 @@
+#ifndef CHECKPOINT_H
+#define CHECKPOINT_H
+
+#include "MappedFile.h"
+#include <cstdint>
+#include <string>
+
+/*
+====================================================================================
+Checkpoint file format, version CHECKPOINT_VERSION
+    CheckpointHeader    fixed size, at offset 0
+    sections            one array per CheckpointSection, each starting on a
+                        CHECKPOINT_ALIGNMENT byte boundary and listed in the
+                        header's section table
+
+    Everything is stored in the writer's native byte order and layout, which the
+    header's byteOrder and headerSize fields check on load. A file is read by
+    mapping it into memory and copying each section out in one block, with no
+    parsing beyond the header.
+====================================================================================
+*/
+
+const std::uint32_t CHECKPOINT_VERSION = 3;       // 2 added object ids, 3 the sweep axis
+const std::uint32_t CHECKPOINT_BYTE_ORDER = 0x01020304;
+const std::uint64_t CHECKPOINT_ALIGNMENT = 64;     // a cache line, as for AlignedVector
+
+enum class CheckpointSection : std::uint32_t
+{
+    PosX, PosY, VelX, VelY, AclX, AclY,
+    Mass, Radius, Restitution, Collided, Asleep, CalmTime, AnchorX, AnchorY, Colour, Id,
+    Spawners,           // CheckpointSpawner records
+    SpawnerIds,         // every spawner id, back to back
+    Rng,                // the solver's engine, as written by its operator<<
+    Count
+};
+
+const int CHECKPOINT_SECTION_COUNT = int(CheckpointSection::Count);
+
+/// <summary>
+/// Where one section lies in the file.
+/// </summary>
+struct CheckpointSectionEntry
+{
+    std::uint64_t offset;               // bytes from the start of the file, a multiple of CHECKPOINT_ALIGNMENT
+    std::uint64_t count;                // elements
+    std::uint32_t elementSize;          // bytes per element
+    std::uint32_t reserved;
+};
+
+/// <summary>
+/// One spawner, with its id kept in the <c>SpawnerIds</c> section.
+/// </summary>
+struct CheckpointSpawner
+{
+    float posX, posY;
+    float velX, velY;
+    float interval;
+    float elapsed;
+    std::uint32_t idOffset;             // first byte of the id in SpawnerIds
+    std::uint32_t idLength;
+    std::uint8_t colour[4];             // r, g, b, a
+    std::uint8_t active;
+    std::uint8_t visible;
+    std::uint8_t reserved[2];
+};
+
+/// <summary>
+/// Start of every checkpoint: format fields, every scalar of the solver's state, and the section table.
+/// </summary>
+struct CheckpointHeader
+{
+    char magic[8];                      // "VVCHKPT" and a terminating 0
+    std::uint32_t version;
+    std::uint32_t byteOrder;            // CHECKPOINT_BYTE_ORDER as the writer stored it
+    std::uint32_t headerSize;           // sizeof(CheckpointHeader) of the writer
+    std::uint32_t reserved;
+    std::uint64_t fileSize;
+
+    std::int64_t frameCount;
+    std::uint64_t stateHash;            // Solver::getStateHash when saved, so loading need not recompute it
+    std::int32_t objectCount;
+    std::int32_t spawnerCount;
+    std::uint32_t nextObjectId;         // ParticleStore::nextId
+    float gravityX, gravityY;
+    std::int32_t boundsLeft, boundsRight, boundsUp, boundsDown;
+    std::int32_t gridWidth, gridHeight;
+    std::int32_t minRadius, maxRadius;  // range of the random objects the solver creates
+    std::int32_t framerate;
+    std::int32_t substeps, minSubsteps;
+    float cflLimit;
+    float sleepDrift, sleepTime, wakeSpeed;
+    std::int32_t reorderInterval;
+    float reorderDisorder;
+    std::int32_t framesSinceReorder;
+    std::int32_t maxObjects;
+    float spawnInterval;
+    std::uint32_t seed;
+    std::uint32_t broadphase;           // BroadphaseKind
+    std::uint8_t gridMultiLevel, gridIncremental;
+    std::uint8_t adaptiveSubsteps, sleeping, jacobiContacts, deterministic;
+    std::uint8_t autoSpawning, paused;
+    std::uint8_t sweepAxis;             // SweepBroadphase::getAxis, kept by a sweep that resumes
+
+    CheckpointSectionEntry sections[CHECKPOINT_SECTION_COUNT];
+};
+
+/// <summary>
+/// Gathers the sections of a checkpoint and writes them out behind a header.
+/// </summary>
+class CheckpointWriter
+{
+private:
+    struct Part
+    {
+        const void* data;
+        std::uint64_t count;
+        std::uint32_t elementSize;
+    };
+
+    Part parts[CHECKPOINT_SECTION_COUNT] = {};
+
+public:
+    void add(CheckpointSection, const void*, std::uint32_t, std::uint64_t);
+
+    /// <summary>
+    /// Adds a contiguous container as a section. The data must stay alive until <c>write</c>.
+    /// </summary>
+    template <typename Vector>
+    void add(CheckpointSection section, const Vector& values)
+    {
+        add(section, values.data(), std::uint32_t(sizeof(values[0])), values.size());
+    }
+
+    bool write(const std::string&, CheckpointHeader&, std::string&) const;
+};
+
+/// <summary>
+/// Read-only memory map of a checkpoint file, checked against the format when opened.
+/// </summary>
+class CheckpointFile
+{
+private:
+    MappedFile map;
+
+public:
+    bool open(const std::string&, std::string&);
+    const CheckpointHeader& header() const;
+    const void* section(CheckpointSection, std::uint32_t, std::uint64_t) const;
+
+    /// <summary>
+    /// Copies a section into a container in one block.
+    /// </summary>
+    /// <param name="id"></param>
+    /// <param name="count">Number of elements the section must hold.</param>
+    /// <param name="values">Replaced by the section's elements.</param>
+    /// <returns>False, leaving <c>values</c> untouched, if the section has another size or element size.</returns>
+    template <typename Vector>
+    bool read(CheckpointSection id, std::uint64_t count, Vector& values) const
+    {
+        using Element = typename Vector::value_type;
+        const Element* first = static_cast<const Element*>(section(id, std::uint32_t(sizeof(Element)), count));
+        if (!first && count > 0) return false;
+        values.assign(first, first + count);
+        return true;
+    }
+};
+
+#endif
@@ -76,6 +76,11 @@ private:
 	// parameter inputs
 	QComboBox* fpsDropdown;
 	QLineEdit* substepsInput;
+	QCheckBox* adaptiveSubstepsCheck;
+	QLineEdit* minSubstepsInput;
+	QCheckBox* sleepingCheck;
+	QCheckBox* jacobiContactsCheck;
+	QCheckBox* deterministicCheck;
 	QLineEdit* maxObjectsInput;
 	VectorInput* gInput;
 
@@ -122,6 +127,11 @@ signals:
 	void restartConfirmed();
 	void applyFramerate(int);
 	void applySubsteps(int);
+	void applyAdaptiveSubsteps(bool);
+	void applyMinSubsteps(int);
+	void applySleeping(bool);
+	void applyJacobiContacts(bool);
+	void applyDeterministic(bool);
 	void applyMaxObjects(int);
 	void applyGravity(float, float);
 	void addSpawner(SpawnerDTO);
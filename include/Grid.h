@@ -1,16 +1,50 @@
 #ifndef GRID_H
 #define GRID_H
 
+#include <cstdint>
 #include <vector>
 #include "Objects.h"
+#include "ParticleStore.h"
+
+/// <summary>
+/// Read-only range of object indices belonging to one grid cell.
+/// </summary>
+struct CellSpan
+{
+	const int* first;
+	const int* last;
+
+	const int* begin() const { return first; }
+	const int* end() const { return last; }
+	int size() const { return int(last - first); }
+	bool empty() const { return first == last; }
+	int operator[](int i) const { return first[i]; }
+};
 
 class Grid
 {
+private:
+	std::vector<int> cellCursor;	// per-cell write position, scratch for the counting sort
+	std::vector<int> objectCell;	// per-object cell index from the last partition
+	std::vector<int> objectSlot;	// per-object position in cellObjects, kept by the incremental update
+	std::vector<int> nextCell;		// per-object cell index being partitioned into, scratch
+	std::vector<int> migrants;		// objects whose cell changed, scratch for the incremental update
+	bool cellsValid;				// false until the first rebuild and after any resize or reset
+	int migratedCount;				// objects that changed cell in the last partition
+	int partitionedCount;			// objects partitioned in the last partition, members only
+
+	int clampedCellIdx(float, float) const;
+	void rebuildCells(const std::vector<int>&);
+	void moveObject(int, int);
+
 public:
-	std::vector<std::vector<Circle*>> cells;
+	std::vector<int> cellStart;		// cell c owns cellObjects[cellStart[c], cellStart[c + 1])
+	std::vector<int> cellObjects;	// object indices sorted by cell
+	std::vector<std::uint8_t> cellAwake;	// 1 when the cell holds at least one awake object
 	int CELL_SIZE;
 	int WIDTH;
 	int HEIGHT;
+	bool incremental;				// move only objects that changed cell instead of rebuilding every partition
 
 	Grid();
 	Grid(int, int, int);
@@ -19,12 +53,20 @@ public:
 
 	void resetCells();
 	int positionToCellIdx(const Vec2D&);
-	void partitionObjects(std::vector<Circle>&);
+	int positionToCellIdx(float, float);
+	void partitionObjects(const ParticleStore&);
+	void partitionObjects(const ParticleStore&, const std::vector<int>&);
+
+	int getCellCount() const;
+	int getObjectCount() const;
+	float getMigrationFraction() const;
+	float getDisorder() const;
+	CellSpan getCell(int) const;
 
-	bool isTopRow(int);
-	bool isBottomRow(int);
-	bool isLeftCol(int);
-	bool isRightCol(int);
+	bool isTopRow(int) const;
+	bool isBottomRow(int) const;
+	bool isLeftCol(int) const;
+	bool isRightCol(int) const;
 
 	std::string toString();
 	std::string info();
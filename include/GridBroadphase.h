@@ -0,0 +1,42 @@
+#ifndef GRIDBROADPHASE_H
+#define GRIDBROADPHASE_H
+
+#include "Broadphase.h"
+#include "GridHierarchy.h"
+
+/// <summary>
+/// Broadphase over the uniform grid levels of a <c>GridHierarchy</c>. Every cell is handed to the
+/// resolver together with the forward half of its neighbourhood, in column stripes on the pool.
+/// </summary>
+class GridBroadphase : public Broadphase
+{
+private:
+    static const int STRIPE_WIDTH = 2;  // grid columns per collision stripe, must be at least 1
+
+    GridHierarchy grids;
+    std::vector<long long> stripeWork[2];  // per colour, running total of kernelWork over its stripes
+
+    static bool isKernelAwake(const Grid&, int);
+    static long long kernelWork(const Grid&, int);
+
+    void collideLevel(const Grid&, const ParticleStore&, WorkerPool&, const BatchResolver&);
+    void collideAcrossLevels(const ParticleStore&, WorkerPool&, const BatchResolver&);
+    void collideStripe(const Grid&, int, int, const ParticleStore&, int, const BatchResolver&);
+
+public:
+    GridHierarchy& getGrids();
+    const GridHierarchy& getGrids() const;
+
+    const char* getName() const override;
+    void setRadiusRange(int, int) override;
+    void update(const ParticleStore&) override;
+    void collide(const ParticleStore&, WorkerPool&, const BatchResolver&) override;
+    void forEachNearPair(const ParticleStore&, float, const PairVisitor&) override;
+    void reset() override;
+
+    float getMigrationFraction() const override;
+    float getDisorder() const override;
+    void getTraversalOrder(std::vector<int>&) const override;
+};
+
+#endif
@@ -0,0 +1,88 @@
+#ifndef GRIDHIERARCHY_H
+#define GRIDHIERARCHY_H
+
+#include <algorithm>
+#include <vector>
+#include "Grid.h"
+#include "ParticleStore.h"
+
+/// <summary>
+/// Stack of grids whose cell sizes grow fourfold from one level to the next. Each object is binned
+/// into the finest level that takes its radius, so small objects are never spread over cells sized
+/// for the largest one. Objects only meet objects of their own level through that
+/// level's cells; pairs across levels are found by querying finer levels from the coarser object.
+/// </summary>
+class GridHierarchy
+{
+private:
+	static const int LEVEL_RATIO = 4;	// radius bound of one level over that of the level below it
+
+	std::vector<Grid> levels;
+	std::vector<std::vector<int>> levelMembers;	// ascending object indices binned into each level, unused with one level
+	std::vector<int> levelRadius;	// largest radius binned into each level
+	int assignedCount;				// objects binned into levels, -1 when they must be binned again
+	int boundsWidth;
+	int boundsHeight;
+	int minRadius;					// radius range of the objects, see setRadiusRange
+	int maxRadius;
+	int builtMinRadius;				// radius range the levels were built for
+	int builtMaxRadius;
+	bool builtMultiLevel;
+
+	void buildLevels();
+	void assignLevels(const ParticleStore&);
+
+public:
+	bool incremental;				// passed on to every level, see Grid::incremental
+	bool multiLevel;				// false keeps every object in one level sized for the maximum radius
+
+	GridHierarchy();
+	GridHierarchy(int, int);
+
+	void setGridSize(const int, const int);
+	void setRadiusRange(int, int);
+
+	void resetCells();
+	void partitionObjects(const ParticleStore&);
+
+	int getWidth() const;
+	int getHeight() const;
+	int getLevelCount() const;
+	const Grid& getLevel(int) const;
+	float getFinerMargin(int) const;
+	float getMigrationFraction() const;
+	float getDisorder() const;
+	void getTraversalOrder(std::vector<int>&) const;
+
+	/// <summary>
+	/// Visits the objects of every level finer than <c>level</c> that could lie within <c>reach</c>
+	/// of a point, as one span per grid column. Finer objects are no larger than their level's radius
+	/// bound, so the searched area is grown by that much on every side.
+	/// </summary>
+	/// <param name="level">Level of the querying object. Level 0 has nothing finer.</param>
+	/// <param name="x"></param>
+	/// <param name="y"></param>
+	/// <param name="reach">Radius of the querying object plus any slack.</param>
+	/// <param name="visit">Called with each non-empty <c>CellSpan</c>.</param>
+	template <typename Visit>
+	void forEachFinerSpan(int level, float x, float y, float reach, Visit visit) const {
+		for (int l = 0; l < level; l++) {
+			const Grid& grid = levels[l];
+			if (grid.getObjectCount() == 0) continue;
+
+			float extent = reach + float(levelRadius[l]);
+			int colLo = std::clamp(int((x - extent) / grid.CELL_SIZE), 0, grid.WIDTH - 1);
+			int colHi = std::clamp(int((x + extent) / grid.CELL_SIZE), 0, grid.WIDTH - 1);
+			int rowLo = std::clamp(int((y - extent) / grid.CELL_SIZE), 0, grid.HEIGHT - 1);
+			int rowHi = std::clamp(int((y + extent) / grid.CELL_SIZE), 0, grid.HEIGHT - 1);
+
+			// the rows of one column are consecutive cells, so they form one contiguous range
+			for (int col = colLo; col <= colHi; col++) {
+				CellSpan span{ grid.getCell(rowLo + col * grid.HEIGHT).begin(), grid.getCell(rowHi + col * grid.HEIGHT).end() };
+				if (!span.empty()) visit(span);
+			}
+		}
+	}
+};
+
+#endif
@@ -0,0 +1,76 @@
+#ifndef HASHBROADPHASE_H
+#define HASHBROADPHASE_H
+
+#include "Broadphase.h"
+#include <cstdint>
+
+/// <summary>
+/// Uniform grid that stores only its occupied cells, found through an open-addressing table keyed by
+/// cell coordinates. Memory follows the object count rather than the area covered, so the world can
+/// be any size and needs no resizing. Cells are kept in column order and span the largest diameter, as
+/// in a single-level <c>Grid</c>, so the kernels and schedule match <c>GridBroadphase</c> with one
+/// level and, within the bounds, so do the results.
+/// </summary>
+class HashBroadphase : public Broadphase
+{
+private:
+    static const int STRIPE_WIDTH = 2;  // cell columns per collision stripe, must be at least 1
+    static const int MAX_COORD = 1 << 30;   // cell coordinates are clamped to +-MAX_COORD
+    static const int RADIX_BITS = 11;   // bits of the cell rank sorted per pass in update
+
+    // a slot of the open-addressing table
+    struct Slot
+    {
+        std::uint64_t key;
+        int cell;                       // -1 when the slot is empty
+    };
+
+    int maxRadius;                      // px, of the objects, see setRadiusRange
+    float cellSize;                     // px, twice the maximum radius, as in a single-level Grid
+    float invCellSize;
+    std::vector<std::uint64_t> objectKey;   // cell key of each object at the last update
+    std::vector<std::uint64_t> cellKey;     // key of each occupied cell, ascending, so in column order
+    std::vector<int> cellStart;         // cell k holds cellObjects[cellStart[k], cellStart[k + 1])
+    std::vector<int> cellObjects;       // object indices, cell by cell, ascending within a cell
+    std::vector<std::uint64_t> entryKey;    // cell rank of each entry of cellObjects, ascending
+    std::vector<std::uint8_t> cellAwake;    // 1 if cell k holds an awake object
+    std::vector<Slot> slots;            // table of occupied cells, keyed by cell coordinates
+    std::vector<int> stripeStart;       // stripe s holds cells [stripeStart[s], stripeStart[s + 1])
+    std::vector<int> colourStripes[2];  // stripes of each colour, in column order
+    std::vector<long long> stripeWork[2];   // per colour, running total of kernelWork over its stripes
+    std::vector<std::uint64_t> sortKeyScratch;  // scratch for the radix sort in update
+    std::vector<int> sortObjectScratch; // scratch for the radix sort in update
+    std::vector<int> digitStart;        // scratch for the radix sort in update
+    int slotMask;                       // slots.size() - 1, a power of two minus one
+    int migratedCount;                  // objects that changed cell in the last update
+
+    static std::uint64_t makeKey(int, int);
+    static int keyCol(std::uint64_t);
+    static int keyRow(std::uint64_t);
+    static int stripeOf(int);
+
+    int coord(float) const;
+    int findSlot(std::uint64_t) const;
+    int findCell(int, int) const;
+    void findKernel(int, int&, int&, int&) const;
+    bool isKernelAwake(int, int, int, int) const;
+    long long kernelWork(int) const;
+
+public:
+    HashBroadphase();
+
+    const char* getName() const override;
+    void setRadiusRange(int, int) override;
+    void update(const ParticleStore&) override;
+    void collide(const ParticleStore&, WorkerPool&, const BatchResolver&) override;
+    void forEachNearPair(const ParticleStore&, float, const PairVisitor&) override;
+    void reset() override;
+
+    float getMigrationFraction() const override;
+    float getDisorder() const override;
+    void getTraversalOrder(std::vector<int>&) const override;
+
+    int getCellCount() const;
+};
+
+#endif
@@ -0,0 +1,36 @@
+#ifndef MAPPEDFILE_H
+#define MAPPEDFILE_H
+
+#include <cstdint>
+#include <string>
+
+/// <summary>
+/// Read-only memory map of a whole file, through mmap or a Win32 file mapping.
+/// </summary>
+class MappedFile
+{
+private:
+    const unsigned char* data;
+    std::uint64_t size;
+#if defined(_WIN32)
+    void* fileHandle;
+    void* mappingHandle;
+#else
+    int descriptor;
+#endif
+
+public:
+    MappedFile();
+    ~MappedFile();
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    bool open(const std::string&, bool, std::string&);
+    void close();
+
+    const unsigned char* getData() const;
+    std::uint64_t getSize() const;
+};
+
+#endif
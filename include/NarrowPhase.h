@@ -0,0 +1,48 @@
+#ifndef NARROWPHASE_H
+#define NARROWPHASE_H
+
+#include "AlignedAllocator.h"
+#include <vector>
+
+/*
+Instruction set used by the narrow phase, chosen at build time.
+Define VV_NARROWPHASE_SCALAR to force the portable path.
+*/
+#if defined(VV_NARROWPHASE_SCALAR)
+    #define VV_NARROWPHASE_WIDTH 1
+#elif defined(__AVX2__)
+    #define VV_NARROWPHASE_AVX2
+    #define VV_NARROWPHASE_WIDTH 8
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+    #define VV_NARROWPHASE_SSE2
+    #define VV_NARROWPHASE_WIDTH 4
+#else
+    #define VV_NARROWPHASE_WIDTH 1
+#endif
+
+/// <summary>
+/// Contiguous copy of the positions and radii of the objects in one collision kernel, so they
+/// can be tested against a single object several lanes at a time. The arrays are padded past
+/// <c>size</c> with lanes that can never overlap anything, so the SIMD loop needs no scalar tail.
+/// </summary>
+class CandidateBatch
+{
+public:
+    AlignedVector<float> x;
+    AlignedVector<float> y;
+    AlignedVector<float> radius;
+    std::vector<int> index;     // object index of each lane
+    int size = 0;
+
+    void clear();
+    void gather(const int*, const int*, const float*, const float*, const float*);
+    void seal();
+};
+
+namespace NarrowPhase
+{
+    const char* instructionSet();
+    int nextOverlap(const CandidateBatch&, int, float, float, float);
+}
+
+#endif
@@ -3,21 +3,23 @@
 
 #include "Vec2D.h"
 #include <SFML/Graphics.hpp>
+#include <random>
 #include <vector>
 
+class ParticleStore;
+
 class Circle
 {
-private:
-    static int MAX_RADIUS;
-    static int MIN_RADIUS;
-
 public:
+    static constexpr int DEFAULT_MIN_RADIUS = 10;   // radius range of a new solver
+    static constexpr int DEFAULT_MAX_RADIUS = 20;
+    static constexpr int RADIUS_LIMIT = 300;        // largest maximum radius a solver accepts
+
     Vec2D pos;
     Vec2D vel;
     Vec2D acl;
     float mass;
     float restitutionCoeff;
-    bool collided = false;
     sf::Color colour;
     int radius;
 
@@ -25,14 +27,7 @@ public:
     Circle(const Vec2D&, const Vec2D&, const Vec2D&,
         const float, const float, const sf::Color&, const int);
 
-    void update(float);
-
-    static void setMaxRadius(int);
-    static void setMinRadius(int);
-    static int getMaxRadius();
-    static int getMinRadius();
-
-    static void generateRandomObject(Circle&);
+    static void generateRandomObject(Circle&, int, int, std::mt19937&);
 
 
     std::string toString() const;
@@ -49,7 +44,7 @@ public:
     RectBounds();
     RectBounds(int, int, int, int);
 
-    void applyBounds(std::vector<Circle>&) const;
+    void applyBounds(ParticleStore&) const;
 
     std::string toString() const;
 };
@@ -63,6 +58,7 @@ public:
     Vec2D vel;
     float interval;
     sf::Clock timer;
+    float elapsed;                  // seconds of simulated time since it last fired, used instead of timer by deterministic solvers
     bool active;
     bool visible;
     sf::Color colour;
@@ -0,0 +1,50 @@
+#ifndef PARTICLESTORE_H
+#define PARTICLESTORE_H
+
+#include "AlignedAllocator.h"
+#include "Objects.h"
+#include <cstdint>
+#include <vector>
+
+/// <summary>
+/// Structure-of-arrays storage for every object in the solver. Attributes touched by the
+/// physics passes each live in their own contiguous, cache-line aligned array so a pass only
+/// streams the fields it uses. Display-only attributes are kept apart in <c>colour</c>.
+/// </summary>
+class ParticleStore
+{
+public:
+    // hot attributes, indexed by particle
+    AlignedVector<float> posX;
+    AlignedVector<float> posY;
+    AlignedVector<float> velX;
+    AlignedVector<float> velY;
+    AlignedVector<float> aclX;
+    AlignedVector<float> aclY;
+    AlignedVector<float> mass;
+    AlignedVector<float> radius;
+    AlignedVector<float> restitution;
+    AlignedVector<std::uint8_t> collided;
+    AlignedVector<std::uint8_t> asleep;     // skipped by integration, static in collisions
+    AlignedVector<float> calmTime;          // seconds spent within the sleep drift of the anchor
+    AlignedVector<float> anchorX;           // where the object was when it last became calm
+    AlignedVector<float> anchorY;
+
+    // cold attributes, only read by the renderer
+    std::vector<sf::Color> colour;
+
+    // identity, for following an object through reorders
+    AlignedVector<std::uint32_t> id;        // assigned in order of addition, never reused until clear
+    std::uint32_t nextId = 0;
+
+    int size() const;
+    void reserve(int);
+    void clear();
+
+    void add(const Circle&);
+    Circle get(int) const;
+    void permute(const std::vector<int>&);
+    std::uint64_t hash() const;
+};
+
+#endif
@@ -0,0 +1,108 @@
+#ifndef PROFILER_H
+#define PROFILER_H
+
+#include "TripleBuffer.h"
+#include <chrono>
+#include <vector>
+
+/*
+Per-phase timing of Solver::updateSolver. Build with VV_PROFILING=0 to compile
+every timer out; the stats then stay at zero.
+*/
+#ifndef VV_PROFILING
+    #define VV_PROFILING 1
+#endif
+
+enum class ProfilePhase
+{
+    Gravity,
+    Bounds,
+    Partition,
+    Collision,
+    Restitution,
+    Integrate,
+    Sleep,
+    Spawn,
+    Record,
+    Count
+};
+
+const int PROFILE_PHASE_COUNT = int(ProfilePhase::Count);
+const int PROFILE_WINDOW = 120;    // frames in the rolling window
+
+/// <summary>
+/// Summary of one timed quantity over the rolling window, in milliseconds per frame.
+/// </summary>
+struct PhaseStats
+{
+    double lastMs = 0.0;
+    double minMs = 0.0;
+    double meanMs = 0.0;
+    double maxMs = 0.0;
+    double p99Ms = 0.0;
+};
+
+struct FrameStats
+{
+    PhaseStats phases[PROFILE_PHASE_COUNT];    // summed over all substeps of a frame
+    PhaseStats frame;                           // the whole of updateSolver
+    std::vector<PhaseStats> collisionBusy;      // per worker, time spent in collision jobs
+    long long frameCount = 0;                   // frames recorded so far
+    int window = 0;                             // frames the stats cover, at most PROFILE_WINDOW
+};
+
+class Profiler
+{
+private:
+    std::vector<long long> history;            // PROFILE_WINDOW rows of (phases..., frame, busy...), in ns
+    std::vector<double> sortScratch;
+    long long current[PROFILE_PHASE_COUNT];
+    std::vector<long long> currentBusy;        // per worker
+    long long frameCount;
+    int head;
+    int filled;
+    TripleBuffer<FrameStats> published;
+
+public:
+    Profiler();
+
+    void setWorkerCount(int);
+    void add(ProfilePhase, long long);
+    void addCollisionBusy(int, long long);
+    void endFrame(long long);
+    FrameStats latest();
+
+    static const char* phaseName(ProfilePhase);
+};
+
+/// <summary>
+/// Adds the lifetime of the timer to one phase of the current frame.
+/// </summary>
+class ScopedPhaseTimer
+{
+private:
+    Profiler& profiler;
+    ProfilePhase phase;
+    std::chrono::steady_clock::time_point start;
+
+public:
+    ScopedPhaseTimer(Profiler& profiler, ProfilePhase phase)
+        : profiler(profiler), phase(phase), start(std::chrono::steady_clock::now()) {}
+
+    ~ScopedPhaseTimer()
+    {
+        auto elapsed = std::chrono::steady_clock::now() - start;
+        profiler.add(phase, std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count());
+    }
+};
+
+#define VV_PROFILE_CONCAT_(a, b) a##b
+#define VV_PROFILE_CONCAT(a, b) VV_PROFILE_CONCAT_(a, b)
+
+#if VV_PROFILING
+    #define VV_PROFILE_PHASE(profiler, phase) ScopedPhaseTimer VV_PROFILE_CONCAT(phaseTimer, __LINE__)(profiler, phase)
+#else
+    #define VV_PROFILE_PHASE(profiler, phase) ((void)0)
+#endif
+
+#endif
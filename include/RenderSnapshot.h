@@ -0,0 +1,30 @@
+#ifndef RENDERSNAPSHOT_H
+#define RENDERSNAPSHOT_H
+
+#include "Objects.h"
+#include "AlignedAllocator.h"
+#include <vector>
+
+class ParticleStore;
+
+/// <summary>
+/// The subset of solver state the renderer needs for one frame. The solver fills one at the
+/// end of every frame and hands it over through a <c>TripleBuffer</c>; arrays are resized in
+/// place, so once they reach their peak size no frame allocates.
+/// </summary>
+struct RenderSnapshot
+{
+    std::vector<float> posX;
+    std::vector<float> posY;
+    std::vector<float> previousX;   // positions one solver frame earlier, for render interpolation
+    std::vector<float> previousY;
+    std::vector<float> radius;
+    std::vector<sf::Color> colour;
+    RectBounds bounds;
+    long long frame = 0;            // solver frames completed when the snapshot was taken
+
+    int size() const;
+    void capture(const ParticleStore&, const AlignedVector<float>&, const AlignedVector<float>&, const RectBounds&, long long);
+};
+
+#endif
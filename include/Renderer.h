@@ -2,6 +2,7 @@
 #define RENDERER_H
 
 #include "./Solver.h"
+#include "./WorkerPool.h"
 #include <SFML/Graphics.hpp>
 
 class Renderer : public QObject
@@ -9,14 +10,25 @@ class Renderer : public QObject
     Q_OBJECT
 
 private:
+    static const int CIRCLE_TEXTURE_SIZE = 64;      // pixels per side of the pre-rendered circle
+    static const int VERTICES_PER_OBJECT = 6;       // two triangles per textured quad
+
     sf::Color bgColour;
     sf::Color ballColour;
     bool randomBallColour;
 
+    sf::Texture circleTexture;                      // white anti-aliased disc, tinted per vertex
+    bool circleTextureReady;
+    sf::VertexArray objectVertices;                 // every object, submitted in one draw call
+    WorkerPool workers;                             // fills objectVertices in parallel chunks
+
+    void createCircleTexture();
+
 public:
     Renderer();
 
-    void renderSolver(Solver &, sf::RenderWindow &);
+    void renderSolver(Solver &, sf::RenderWindow &, float = 1.f);
+    void renderSnapshot(const RenderSnapshot &, sf::RenderWindow &, float = 1.f);
 
 public slots:
     void setBackgroundRed(int);
@@ -2,57 +2,167 @@
 #define SOLVER_H
 
 #include "Objects.h"
-#include "Grid.h"
+#include "GridBroadphase.h"
+#include "HashBroadphase.h"
+#include "SweepBroadphase.h"
+#include "ParticleStore.h"
 #include "DTO.h"
+#include "WorkerPool.h"
+#include "NarrowPhase.h"
+#include "Profiler.h"
+#include "RenderSnapshot.h"
+#include "TripleBuffer.h"
+#include "Checkpoint.h"
+#include "TrajectoryRecorder.h"
+
+#include <atomic>
+#include <random>
 
 #include <QtCore/qobject.h>
-#include <QtWidgets/qabstractbutton.h>
 
 class Solver : public QObject
 {
     Q_OBJECT
 
 private:
-    std::vector<Circle> objects;
+    static const int SLEEP_RETRY_FRAMES = 15;   // frames between island passes while calm objects are held awake
+    static const int DISORDER_CHECK_FRAMES = 8; // frames between checks for an early reorder, see isReorderDue
+
+    // per-worker state for the parallel passes, padded so workers never share a cache line
+    struct alignas(64) CollisionScratch
+    {
+        long long pairTests = 0;
+        float maxSpeedSq = 0.f;         // partial result of the substep reduction
+    };
+
+    ParticleStore objects;
     std::vector<Spawner> spawners;
-    Grid grid;
+    GridBroadphase gridBroadphase;
+    SweepBroadphase sweepBroadphase;
+    HashBroadphase hashBroadphase;
+    Broadphase* broadphase;             // the one of the above matching activeBroadphase
+    BroadphaseKind activeBroadphase;
+    WorkerPool workers;
+    std::vector<CollisionScratch> collisionScratch;
+    Profiler profiler;
+    TripleBuffer<RenderSnapshot> renderSnapshots;
+    TrajectoryRecorder recorder;        // idle until started through getRecorder
+    AlignedVector<float> frameStartX;   // object positions when the current frame began
+    AlignedVector<float> frameStartY;
+    std::atomic<bool> restartPending;   // set by restart(), applied by the solver thread
+    std::atomic<bool> wakePending;      // set by wakeAll(), applied by the solver thread
+    std::atomic<BroadphaseKind> requestedBroadphase;    // set by setBroadphase(), applied by the solver thread
+    std::atomic<bool> seedPending;      // set by setSeed(), applied by the solver thread
+    std::atomic<int> reservePending;    // capacity set by setMaxObjects(), reserved by the solver thread, 0 = none
+    std::mt19937 rng;                   // draws every random object the solver creates
+    std::uint64_t stateHash;            // ParticleStore::hash after the last frame, with DETERMINISTIC set
+    std::vector<int> islandParent;      // union-find forest over contact islands, scratch for updateSleep
+    std::vector<std::uint8_t> islandBlocked;
+    AlignedVector<float> contactShiftX;     // per object, position corrections gathered this substep, see applyContacts
+    AlignedVector<float> contactShiftY;
+    AlignedVector<float> contactImpulseX;   // per object, velocity changes gathered this substep
+    AlignedVector<float> contactImpulseY;
+    AlignedVector<int> contactCount;        // per object, contacts counted this substep before any is gathered
+    AlignedVector<std::uint8_t> contactWake;    // 1 if an impact this substep wakes the sleeping object
+    long long frameCount;
     Vec2D GRAVITY;
     RectBounds BOUNDS;
     int FRAMERATE;                  // fps
-    int SUBSTEPS;
+    int SUBSTEPS;                   // fixed count, or the upper bound when ADAPTIVE_SUBSTEPS is set
+    int MIN_SUBSTEPS;               // lower bound when ADAPTIVE_SUBSTEPS is set
+    bool ADAPTIVE_SUBSTEPS;
+    float CFL_LIMIT;                // max travel per substep, as a fraction of the minimum radius
+    bool DETERMINISTIC;             // time spawners by simulated time and hash the state every frame
+    unsigned SEED;                  // seed of rng, reapplied on restart when DETERMINISTIC is set
+    bool JACOBI_CONTACTS;           // gather every contact of a substep before applying any, see applyContacts
+    bool SLEEPING;
+    float SLEEP_DRIFT;              // px an object may wander from its anchor and still count as calm
+    float SLEEP_TIME;               // seconds an island must stay calm before it sleeps
+    float WAKE_SPEED;               // px/s, impact speed at which a sleeping object wakes
+    int REORDER_INTERVAL;           // frames between spatial reorders of the objects, 0 = never
+    float REORDER_DISORDER;         // grid disorder at which objects are reordered early, see GridHierarchy::getDisorder
     int MAX_OBJECTS;
+    int MIN_RADIUS;                 // px, range of the random objects the solver creates
+    int MAX_RADIUS;
     float SPAWN_INTERVAL;           // seconds
+    long long pairTestCount;        // narrow-phase pair tests in the last substep
+    int frameSubsteps;              // substeps taken by the last frame
+    int asleepCount;                // sleeping objects after the last frame
+    float migrationFraction;        // mean share of objects that changed grid cell per substep, last frame
+    int framesSinceReorder;
+    int reorderCount;
+    std::vector<int> reorderScratch;    // new object order, scratch for reorderObjects
 
     void applyGravity();
     void applyCollisions();
     void applyRestitution();
     void updateObjects(float);
+    void spawnObjects(float);
+    int chooseSubsteps(float);
+    void updateSleep(float);
+    void reorderObjects();
+    bool isReorderDue(int) const;
+    int findIsland(int);
+    void publishSnapshot();
 
-    void collisionDetectionThread(int, int);
+    void resolveBatch(CandidateBatch&, int, CollisionScratch&);
+    void resolveCollision(int, int);
+    void resolveStaticCollision(int, float, float, float, float);
+    void countBatch(CandidateBatch&, int);
+    void countContact(int, int);
+    void gatherBatch(CandidateBatch&, int, CollisionScratch&);
+    void gatherContact(int, int);
+    void applyContacts();
         
 public:
     bool paused;
     bool autoSpawning;
 
     Solver();
+    Solver(int);
 
     void setGravity(const Vec2D&);
     void setBounds(const RectBounds&);
     void setSpawnInterval(float);
+    void setBroadphase(BroadphaseKind);
 
     Vec2D getGravity() const;
     RectBounds* getBounds();
-    Grid* getGrid();
+    GridHierarchy* getGrid();
+    TrajectoryRecorder* getRecorder();
+    BroadphaseKind getBroadphase() const;
+    const char* getBroadphaseName() const;
     int getFramerate() const;
     int getSubsteps() const;
+    int getMinSubsteps() const;
+    bool getAdaptiveSubsteps() const;
+    int getFrameSubsteps() const;
+    bool getJacobiContacts() const;
+    bool getDeterministic() const;
+    unsigned getSeed() const;
+    std::uint64_t getStateHash() const;
+    bool getSleeping() const;
+    int getAwakeCount() const;
+    int getAsleepCount() const;
+    float getMigrationFraction() const;
+    int getReorderCount() const;
+    int getThreadCount() const;
+    long long getPairTestCount() const;
+    FrameStats getFrameStats();
     int getMaxObjects() const;
+    int getMinRadius() const;
+    int getMaxRadius() const;
     float getSpawnInterval() const;
     int getObjectCount() const;
-    const std::vector<Circle>& getObjects() const;
+    const ParticleStore& getObjects() const;
+    const RenderSnapshot& getRenderSnapshot();
         
     void addObject(const Circle&);
     void addSpawner(const Spawner&);
     void updateSolver(float);
+    void wakeAll();
+    bool saveCheckpoint(const std::string&) const;
+    bool loadCheckpoint(const std::string&);
 
 signals:
     void returnSpawner(Spawner*);
@@ -65,7 +175,16 @@ public slots:
     void setAutoSpawning(bool);
     void setFramerate(int);
     void setSubsteps(int);
+    void setMinSubsteps(int);
+    void setAdaptiveSubsteps(bool);
+    void setJacobiContacts(bool);
+    void setDeterministic(bool);
+    void setSeed(unsigned);
+    void setSleeping(bool);
+    void setReorderInterval(int);
     void setMaxObjects(int);
+    void setMinRadius(int);
+    void setMaxRadius(int);
     void setGravity(float, float);
 
     void addSpawner(SpawnerDTO);
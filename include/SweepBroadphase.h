@@ -0,0 +1,48 @@
+#ifndef SWEEPBROADPHASE_H
+#define SWEEPBROADPHASE_H
+
+#include "Broadphase.h"
+
+/// <summary>
+/// Sort and sweep along one axis. Objects are kept sorted by the lower end of their extent on the
+/// axis, and each object is handed to the resolver with every later object whose extent starts
+/// before its own ends. The order is carried over between updates and repaired with an insertion
+/// sort, which is close to linear while objects only move a little per substep.
+/// </summary>
+class SweepBroadphase : public Broadphase
+{
+private:
+    static const int MIN_CHUNK = 256;   // sorted entries per chunk, before widening to cover the windows
+    static const int LOCAL_SPAN = 16;   // index distance still counted as in order by getDisorder, a cache line of floats
+
+    std::vector<int> order;             // object indices, sorted by lower
+    std::vector<float> lower;           // lower end of each sorted entry's extent on the sweep axis
+    std::vector<int> windowEnd;         // one past the last sorted entry whose extent may overlap entry k's
+    std::vector<int> chunkStart;        // chunk c holds sorted entries [chunkStart[c], chunkStart[c + 1])
+    std::vector<long long> chunkWork[2];    // per colour, running total of the lane tests of its chunks
+    int axis;                           // 0 sweeps along x, 1 along y
+    int movedCount;                     // entries the last insertion sort moved
+    bool orderValid;                    // false until the first sort and after a reset
+    bool keepAxis;                      // the next sort keeps axis instead of choosing it, see resume
+
+    void rebuildOrder(const ParticleStore&);
+    void buildChunks();
+
+public:
+    SweepBroadphase();
+
+    const char* getName() const override;
+    void setRadiusRange(int, int) override;
+    void update(const ParticleStore&) override;
+    void collide(const ParticleStore&, WorkerPool&, const BatchResolver&) override;
+    void forEachNearPair(const ParticleStore&, float, const PairVisitor&) override;
+    void reset() override;
+    void resume(int);
+    int getAxis() const;
+
+    float getMigrationFraction() const override;
+    float getDisorder() const override;
+    void getTraversalOrder(std::vector<int>&) const override;
+};
+
+#endif
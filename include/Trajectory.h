@@ -0,0 +1,169 @@
+#ifndef TRAJECTORY_H
+#define TRAJECTORY_H
+
+#include "Objects.h"
+#include "MappedFile.h"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+class ParticleStore;
+
+/*
+====================================================================================
+Trajectory file format, version TRAJECTORY_VERSION
+    TrajectoryHeader        fixed size, at offset 0
+    chunks                  each a TrajectoryChunkHeader and the chunk's frames,
+                            compressed together with qCompress
+    index                   one TrajectoryIndexEntry per frame, in frame order,
+                            starting on a TRAJECTORY_INDEX_ALIGNMENT byte boundary
+    TrajectoryFooter        fixed size, at the end of the file
+
+    A chunk's frames are each a TrajectoryFrameHeader followed by the frame's
+    fields, one after the other: ids, then x, y, vx, vy, radius and colour of
+    every object. Each value is quantised to an integer, stored as the
+    difference from the same object index in the previous frame of the chunk,
+    zigzag mapped and written as a varint. The first frame of a chunk is a
+    keyframe, coded against zeros, so any chunk decodes on its own.
+
+    Everything is stored in the writer's native byte order and layout, checked
+    through the header's byteOrder field.
+====================================================================================
+*/
+
+const std::uint32_t TRAJECTORY_VERSION = 3;       // 2 added the frame time, 3 aligned the index
+const std::uint32_t TRAJECTORY_BYTE_ORDER = 0x01020304;
+const std::uint64_t TRAJECTORY_INDEX_ALIGNMENT = 8; // the index entries' alignment, so the mapped index is read in place
+
+/// <summary>
+/// Start of every trajectory file.
+/// </summary>
+struct TrajectoryHeader
+{
+    char magic[8];                      // "VVTRAJ" and terminating 0s
+    std::uint32_t version;
+    std::uint32_t byteOrder;            // TRAJECTORY_BYTE_ORDER as the writer stored it
+    float positionStep;                 // px per quantisation step of positions and radii
+    float velocityStep;                 // px/s per quantisation step of velocities
+    std::uint32_t chunkFrames;          // most frames in one chunk
+    std::uint32_t frameInterval;        // solver frames between recorded frames
+};
+
+/// <summary>
+/// Precedes the compressed frames of one chunk.
+/// </summary>
+struct TrajectoryChunkHeader
+{
+    std::uint32_t frameCount;
+    std::uint32_t reserved;
+    std::uint64_t rawSize;              // bytes of the frames once decompressed
+    std::uint64_t compressedSize;       // bytes following this header
+};
+
+/// <summary>
+/// Precedes the fields of one frame inside a decompressed chunk.
+/// </summary>
+struct TrajectoryFrameHeader
+{
+    std::int64_t frame;                 // solver frames completed when the frame was captured
+    std::uint32_t objectCount;
+    std::int32_t boundsLeft, boundsRight, boundsUp, boundsDown;
+    float frameTime;                    // seconds of simulated time per solver frame
+};
+
+/// <summary>
+/// Where one frame lies in the file.
+/// </summary>
+struct TrajectoryIndexEntry
+{
+    std::int64_t frame;
+    std::uint64_t chunkOffset;          // bytes from the start of the file to the chunk's header
+    std::uint32_t frameInChunk;         // frames of the chunk that precede this one
+    std::uint32_t objectCount;
+};
+
+/// <summary>
+/// End of every complete trajectory file. A file without one was not closed and has no index.
+/// </summary>
+struct TrajectoryFooter
+{
+    std::uint64_t indexOffset;          // bytes from the start of the file to the first index entry
+    std::uint64_t frameCount;           // index entries
+    std::uint64_t droppedFrames;        // frames the recorder skipped because the writer was behind
+    std::uint64_t chunkCount;
+    char magic[8];                      // "VVTREND" and a terminating 0
+};
+
+/// <summary>
+/// One recorded frame: the objects' state as captured from a solver, or as decoded from a file.
+/// Arrays are resized in place, so once they reach their peak size no frame allocates.
+/// </summary>
+struct TrajectoryFrame
+{
+    long long frame = 0;                // solver frames completed when the frame was captured
+    float frameTime = 0.f;              // seconds of simulated time per solver frame
+    RectBounds bounds;
+    std::vector<std::uint32_t> id;
+    std::vector<float> posX;
+    std::vector<float> posY;
+    std::vector<float> velX;
+    std::vector<float> velY;
+    std::vector<float> radius;
+    std::vector<sf::Color> colour;
+
+    int size() const;
+    void resize(int);
+    void capture(const ParticleStore&, const RectBounds&, long long, float);
+};
+
+/// <summary>
+/// Quantises frames and delta codes them against the previous frame of the same chunk. Encoding and
+/// decoding keep the same state, so a decoder fed a chunk's frames in order reproduces the
+/// quantised values the encoder saw.
+/// </summary>
+class TrajectoryCodec
+{
+private:
+    static const int FIELD_COUNT = 7;   // id, x, y, vx, vy, radius, colour
+
+    float positionStep;
+    float velocityStep;
+    std::vector<std::uint32_t> previous[FIELD_COUNT];   // quantised values of the last frame, per field
+
+    static unsigned char* writeVarint(unsigned char*, std::uint32_t);
+    static bool readVarint(const unsigned char*&, const unsigned char*, std::uint32_t&);
+
+public:
+    TrajectoryCodec(float, float);
+
+    void reset();
+    void encode(const TrajectoryFrame&, std::string&);
+    bool decode(const unsigned char*&, const unsigned char*, TrajectoryFrame&);
+};
+
+/// <summary>
+/// Read-only memory map of a complete trajectory file. Only the header, footer and index are read
+/// when it is opened; a chunk's pages are read when the chunk is.
+/// </summary>
+class TrajectoryFile
+{
+private:
+    MappedFile map;
+    const TrajectoryHeader* header;
+    TrajectoryFooter footer;            // copied out of the map, which need not end aligned
+    const TrajectoryIndexEntry* index;
+
+public:
+    TrajectoryFile();
+
+    bool open(const std::string&, std::string&);
+
+    const TrajectoryHeader& getHeader() const;
+    long long getFrameCount() const;
+    long long getDroppedCount() const;
+    const TrajectoryIndexEntry& getEntry(long long) const;
+    long long findFrame(long long) const;
+    bool readChunk(long long, std::string&) const;
+};
+
+#endif
@@ -0,0 +1,88 @@
+#ifndef TRAJECTORYPLAYER_H
+#define TRAJECTORYPLAYER_H
+
+#include "Trajectory.h"
+#include "RenderSnapshot.h"
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+/// <summary>
+/// Plays back a trajectory file (see Trajectory.h) as render snapshots, with no solver. A decoder
+/// thread keeps the frames from the playback position onwards decoded ahead of the render thread,
+/// which only interpolates between two decoded frames. A seek decodes from the start of the target's
+/// chunk, so it costs at most one chunk of frames however long the recording is.
+/// </summary>
+class TrajectoryPlayer
+{
+private:
+    static const int SLOT_COUNT = 4;            // decoded frames kept, from the one being shown onwards
+    static const int EMPTY = -1;                // slot states besides the index of the frame a slot holds
+    static const int DECODING = -2;
+    static constexpr double MIN_SPEED = 1.0 / 64.0;
+    static constexpr double MAX_SPEED = 64.0;
+
+    TrajectoryFile file;
+
+    // shared with the decoder thread; a slot is only written by the decoder while it is DECODING
+    TrajectoryFrame frames[SLOT_COUNT];          // frame index i lives in slot i % SLOT_COUNT
+    long long slotIndex[SLOT_COUNT];
+    long long wantedIndex;                      // first frame of the window the decoder fills
+    std::mutex slotMutex;
+    std::condition_variable wake;               // the decoder parks here while the window is full
+    std::thread decoder;
+    bool stopping;
+    std::atomic<bool> failed;                   // set by the decoder when a chunk is damaged
+
+    // owned by the decoder thread
+    TrajectoryCodec codec;
+    std::string chunk;                          // the decompressed chunk being read
+    std::uint64_t chunkOffset;                  // where that chunk lies in the file
+    size_t cursor;                              // bytes of it already decoded
+    long long nextIndex;                        // frame the cursor is at
+    TrajectoryFrame skipped;                    // frames decoded only to reach a later one
+
+    // owned by the render thread
+    RenderSnapshot snapshot;
+    long long snapshotIndex;                    // frame the snapshot starts at, or -1 before the first
+    long long snapshotStart;                    // solver frame of that frame; the snapshot's own is the one it ends at
+    float frameTime;                            // seconds of simulated time per solver frame, from the snapshot
+    std::vector<int> earlierIndex;              // object id to its index in the earlier frame, -1 if absent
+    double position;                            // playback position, in solver frames
+    double speed;
+    bool paused;
+    bool buffering;                             // the frames at the position are not decoded yet
+
+    void decoderLoop();
+    bool decodeFrame(long long, TrajectoryFrame&);
+    bool isDecoded(long long);
+    void buildSnapshot(const TrajectoryFrame&, const TrajectoryFrame&);
+
+public:
+    TrajectoryPlayer();
+    ~TrajectoryPlayer();
+
+    TrajectoryPlayer(const TrajectoryPlayer&) = delete;
+    TrajectoryPlayer& operator=(const TrajectoryPlayer&) = delete;
+
+    bool open(const std::string&, std::string&);
+    void advance(float);
+
+    const RenderSnapshot& getSnapshot() const;
+    float getAlpha() const;
+
+    void togglePause();
+    bool isPaused() const;
+    bool isBuffering() const;
+    bool hasFailed() const;
+    void setSpeed(double);
+    double getSpeed() const;
+    void seek(double);
+    double getPosition() const;
+    long long getFirstFrame() const;
+    long long getLastFrame() const;
+    float getFrameTime() const;
+};
+
+#endif
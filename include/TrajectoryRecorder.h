@@ -0,0 +1,71 @@
+#ifndef TRAJECTORYRECORDER_H
+#define TRAJECTORYRECORDER_H
+
+#include "Trajectory.h"
+#include <atomic>
+#include <condition_variable>
+#include <fstream>
+#include <mutex>
+#include <thread>
+
+/// <summary>
+/// Streams solver frames to a trajectory file (see Trajectory.h) from a background thread. The solver
+/// thread only copies each frame into a bounded single-producer, single-consumer queue; the writer
+/// thread encodes, compresses and writes it. When the queue is full the frame is dropped and
+/// counted, so a slow disk or codec never stalls the solver.
+/// </summary>
+class TrajectoryRecorder
+{
+private:
+    static const int QUEUE_FRAMES = 8;          // captured frames the writer may fall behind by
+    static const int CHUNK_FRAMES = 32;         // most frames per compressed chunk, so a seek decodes at most this many
+    static const int CHUNK_BYTES = 2 << 20;     // chunks of large frames close early, once this many bytes are coded
+    static const int COMPRESSION_LEVEL = 1;     // zlib level; higher levels cost more than the space they save
+    static constexpr float POSITION_STEP = 1.f / 64.f;  // px
+    static constexpr float VELOCITY_STEP = 1.f / 16.f;  // px/s
+
+    TrajectoryFrame queue[QUEUE_FRAMES];
+    std::atomic<unsigned long long> queueHead;  // frames captured, advanced by the solver thread
+    std::atomic<unsigned long long> queueTail;  // frames encoded, advanced by the writer thread
+    std::thread writer;
+    std::mutex wakeMutex;
+    std::condition_variable wake;               // the writer parks here while the queue is empty
+    std::atomic<bool> stopping;
+    std::atomic<long long> recordedCount;
+    std::atomic<long long> droppedCount;
+    std::atomic<bool> failed;                   // set by the writer thread when the file cannot be written
+    bool recording;
+    int interval;
+    std::string path;
+
+    // owned by the writer thread while recording
+    std::ofstream file;
+    TrajectoryCodec codec;
+    std::string chunkFrames;                    // the current chunk's frames, before compression
+    int chunkFrameCount;
+    std::uint64_t chunkCount;
+    std::uint64_t writtenBytes;
+    std::vector<TrajectoryIndexEntry> index;
+
+    void writerLoop();
+    void writeChunk();
+    void writeBytes(const void*, std::uint64_t);
+
+public:
+    TrajectoryRecorder();
+    ~TrajectoryRecorder();
+
+    TrajectoryRecorder(const TrajectoryRecorder&) = delete;
+    TrajectoryRecorder& operator=(const TrajectoryRecorder&) = delete;
+
+    bool start(const std::string&, int = 1);
+    void stop();
+    void capture(const ParticleStore&, const RectBounds&, long long, float);
+
+    bool isRecording() const;
+    const std::string& getPath() const;
+    long long getRecordedCount() const;
+    long long getDroppedCount() const;
+};
+
+#endif
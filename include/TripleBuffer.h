@@ -0,0 +1,59 @@
+#ifndef TRIPLEBUFFER_H
+#define TRIPLEBUFFER_H
+
+#include <atomic>
+
+/// <summary>
+/// Lock-free single-producer, single-consumer triple buffer. The writer fills <c>writeSlot()</c>
+/// and calls <c>publish()</c>; the reader calls <c>update()</c> and then reads <c>readSlot()</c>.
+/// Neither side ever waits for the other, and the reader always sees the most recently
+/// published complete value.
+/// </summary>
+template <typename T>
+class TripleBuffer
+{
+private:
+    static const int FRESH = 4;     // set on middle when it holds a value the reader has not taken
+
+    T slots[3];
+    std::atomic<int> middle;        // slot handed between writer and reader
+    int back;                       // owned by the writer
+    int front;                      // owned by the reader
+
+public:
+    TripleBuffer() : middle(1), back(0), front(2) {}
+
+    TripleBuffer(const TripleBuffer&) = delete;
+    TripleBuffer& operator=(const TripleBuffer&) = delete;
+
+    /// <summary>
+    /// Writer side. The slot may hold an old value and must be fully overwritten before publishing.
+    /// </summary>
+    T& writeSlot() { return slots[back]; }
+
+    /// <summary>
+    /// Writer side. Hands the filled slot to the reader and takes back a free one.
+    /// </summary>
+    void publish()
+    {
+        back = middle.exchange(back | FRESH, std::memory_order_acq_rel) & 3;
+    }
+
+    /// <summary>
+    /// Reader side. Takes the most recently published slot, if there is one the reader has not seen.
+    /// </summary>
+    /// <returns>true if <c>readSlot()</c> now refers to a newer value.</returns>
+    bool update()
+    {
+        if (!(middle.load(std::memory_order_acquire) & FRESH)) return false;
+        front = middle.exchange(front, std::memory_order_acq_rel) & 3;
+        return true;
+    }
+
+    /// <summary>
+    /// Reader side. Valid until the next call to <c>update()</c>.
+    /// </summary>
+    const T& readSlot() const { return slots[front]; }
+};
+
+#endif
@@ -0,0 +1,46 @@
+#ifndef WORKERPOOL_H
+#define WORKERPOOL_H
+
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+
+class WorkerPool
+{
+private:
+    // a worker's busy time, padded so workers never write to the same cache line
+    struct alignas(64) BusyTime
+    {
+        long long ns = 0;
+    };
+
+    std::vector<std::thread> threads;
+    std::mutex mutex;
+    std::condition_variable wake;       // workers park here between jobs
+    std::condition_variable done;       // caller parks here until the job is finished
+    const std::function<void(int)>* task;
+    unsigned generation;                // bumped once per job
+    int pending;                        // workers still running the current job
+    bool stopping;
+    std::vector<BusyTime> busyTimes;    // per worker, time spent in jobs since resetBusyTimes
+
+    void workerLoop(int);
+    void runTimed(const std::function<void(int)>&, int);
+
+public:
+    WorkerPool(int);
+    ~WorkerPool();
+
+    WorkerPool(const WorkerPool&) = delete;
+    WorkerPool& operator=(const WorkerPool&) = delete;
+
+    int getThreadCount() const;
+    void run(const std::function<void(int)>&);
+
+    void resetBusyTimes();
+    long long getBusyTime(int) const;
+};
+
+#endif
@@ -0,0 +1,173 @@
+#include "../include/Checkpoint.h"
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+
+#if defined(_WIN32)
+#define NOMINMAX
+#include <windows.h>
+#endif
+
+static const char CHECKPOINT_MAGIC[8] = "VVCHKPT";
+
+/// <summary>
+/// Rounds an offset up to the next section boundary.
+/// </summary>
+static std::uint64_t alignOffset(std::uint64_t offset)
+{
+    return (offset + CHECKPOINT_ALIGNMENT - 1) / CHECKPOINT_ALIGNMENT * CHECKPOINT_ALIGNMENT;
+}
+
+/// <summary>
+/// Moves a finished file over the target in one step, replacing any file already there.
+/// </summary>
+static bool replaceFile(const std::string& from, const std::string& to)
+{
+#if defined(_WIN32)
+    return MoveFileExA(from.c_str(), to.c_str(), MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH) != 0;
+#else
+    return std::rename(from.c_str(), to.c_str()) == 0;
+#endif
+}
+
+/*
+====================================================================================
+CHECKPOINT WRITER class
+====================================================================================
+*/
+
+/// <summary>
+/// Sets the data of one section, replacing any added before. The data must stay alive until <c>write</c>.
+/// </summary>
+/// <param name="section"></param>
+/// <param name="data">First element, may be null when <c>count</c> is 0.</param>
+/// <param name="elementSize">Bytes per element.</param>
+/// <param name="count">Number of elements.</param>
+void CheckpointWriter::add(CheckpointSection section, const void* data, std::uint32_t elementSize, std::uint64_t count)
+{
+    parts[int(section)] = Part{ data, count, elementSize };
+}
+
+/// <summary>
+/// Lays the sections out behind the header and writes the file. The file is written next to the
+/// target and renamed over it once complete, so a failed or interrupted write never leaves a
+/// truncated checkpoint where a good one was.
+/// </summary>
+/// <param name="path"></param>
+/// <param name="header">The solver's fields; the format fields and section table are filled in here.</param>
+/// <param name="error">Set to the reason when writing fails.</param>
+/// <returns>True if the whole file was written.</returns>
+bool CheckpointWriter::write(const std::string& path, CheckpointHeader& header, std::string& error) const
+{
+    std::memcpy(header.magic, CHECKPOINT_MAGIC, sizeof header.magic);
+    header.version = CHECKPOINT_VERSION;
+    header.byteOrder = CHECKPOINT_BYTE_ORDER;
+    header.headerSize = std::uint32_t(sizeof(CheckpointHeader));
+    header.reserved = 0;
+
+    std::uint64_t offset = alignOffset(sizeof(CheckpointHeader));
+    for (int s = 0; s < CHECKPOINT_SECTION_COUNT; s++) {
+        header.sections[s] = CheckpointSectionEntry{ offset, parts[s].count, parts[s].elementSize, 0 };
+        offset = alignOffset(offset + parts[s].count * parts[s].elementSize);
+    }
+    header.fileSize = offset;
+
+    const std::string partPath = path + ".part";
+    std::ofstream file(partPath, std::ios::binary | std::ios::trunc);
+    if (!file) {
+        error = "cannot open " + partPath + " for writing";
+        return false;
+    }
+
+    // zero padding up to each section's boundary
+    const char padding[CHECKPOINT_ALIGNMENT] = {};
+    std::uint64_t written = sizeof(CheckpointHeader);
+    file.write(reinterpret_cast<const char*>(&header), sizeof(CheckpointHeader));
+    for (int s = 0; s < CHECKPOINT_SECTION_COUNT; s++) {
+        file.write(padding, std::streamsize(header.sections[s].offset - written));
+        std::uint64_t bytes = parts[s].count * parts[s].elementSize;
+        if (bytes > 0) file.write(static_cast<const char*>(parts[s].data), std::streamsize(bytes));
+        written = header.sections[s].offset + bytes;
+    }
+    file.write(padding, std::streamsize(header.fileSize - written));
+    file.close();
+
+    if (!file) {
+        error = "cannot write " + partPath;
+        std::remove(partPath.c_str());
+        return false;
+    }
+    if (!replaceFile(partPath, path)) {
+        error = "cannot replace " + path;
+        std::remove(partPath.c_str());
+        return false;
+    }
+    return true;
+}
+
+/*
+====================================================================================
+CHECKPOINT FILE class
+====================================================================================
+*/
+
+/// <summary>
+/// Maps a checkpoint into memory and checks that this build can read it: the magic, version, byte
+/// order and header layout must match, and every section must lie inside the file.
+/// </summary>
+/// <param name="path"></param>
+/// <param name="error">Set to the reason when the file cannot be used.</param>
+/// <returns>True if the file is mapped and its sections can be read.</returns>
+bool CheckpointFile::open(const std::string& path, std::string& error)
+{
+    // every section is about to be copied out, so the whole file is read in at once
+    if (!map.open(path, true, error)) return false;
+    std::uint64_t size = map.getSize();
+    if (size < sizeof(CheckpointHeader)) {
+        map.close();
+        error = path + " is too short to be a checkpoint";
+        return false;
+    }
+
+    const CheckpointHeader& h = header();
+    if (std::memcmp(h.magic, CHECKPOINT_MAGIC, sizeof h.magic) != 0) error = path + " is not a checkpoint";
+    else if (h.byteOrder != CHECKPOINT_BYTE_ORDER) error = path + " was written on a machine of the other byte order";
+    else if (h.version != CHECKPOINT_VERSION) error = path + " is checkpoint version " + std::to_string(h.version) + ", expected " + std::to_string(CHECKPOINT_VERSION);
+    else if (h.headerSize != sizeof(CheckpointHeader)) error = path + " was written with another header layout";
+    else if (h.fileSize != size) error = path + " is truncated";
+    else {
+        for (const CheckpointSectionEntry& entry : h.sections) {
+            bool inside = entry.offset % CHECKPOINT_ALIGNMENT == 0 && entry.offset <= size
+                && (entry.elementSize == 0 || entry.count <= (size - entry.offset) / entry.elementSize);
+            if (!inside) {
+                error = path + " has a section outside the file";
+                break;
+            }
+        }
+    }
+
+    if (!error.empty()) {
+        map.close();
+        return false;
+    }
+    return true;
+}
+
+/// <summary>
+/// Getter for the header of an open checkpoint.
+/// </summary>
+const CheckpointHeader& CheckpointFile::header() const { return *reinterpret_cast<const CheckpointHeader*>(map.getData()); }
+
+/// <summary>
+/// Finds a section in the mapped file.
+/// </summary>
+/// <param name="section"></param>
+/// <param name="elementSize">Bytes per element the caller expects.</param>
+/// <param name="count">Number of elements the caller expects.</param>
+/// <returns>The first element, aligned to <c>CHECKPOINT_ALIGNMENT</c>, or null if the section does not match.</returns>
+const void* CheckpointFile::section(CheckpointSection section, std::uint32_t elementSize, std::uint64_t count) const
+{
+    const CheckpointSectionEntry& entry = header().sections[int(section)];
+    if (entry.count != count || (count > 0 && entry.elementSize != elementSize)) return nullptr;
+    return map.getData() + entry.offset;
+}
@@ -177,6 +177,37 @@ void ControlPanel::initParameter(Solver* solver)
 	substepsInput->setPlaceholderText("1-16");
 	substepsInput->setText(QString::fromStdString(std::to_string(solver->getSubsteps())));
 
+	// adaptive substeps, where the substeps input becomes the upper bound
+	QLabel* adaptive = new QLabel("Adaptive", this);
+	adaptive->setAlignment(Qt::AlignRight);
+	adaptiveSubstepsCheck = new QCheckBox("Choose substeps from speed", this);
+	adaptiveSubstepsCheck->setChecked(solver->getAdaptiveSubsteps());
+	QLabel* minSubsteps = new QLabel("Min. Substeps", this);
+	minSubsteps->setAlignment(Qt::AlignRight);
+	minSubstepsInput = new QLineEdit(this);
+	minSubstepsInput->setValidator(new QIntValidator(1, 16, this));
+	minSubstepsInput->setPlaceholderText("1-16");
+	minSubstepsInput->setText(QString::fromStdString(std::to_string(solver->getMinSubsteps())));
+	minSubstepsInput->setEnabled(adaptiveSubstepsCheck->isChecked());
+
+	// sleeping
+	QLabel* sleeping = new QLabel("Sleeping", this);
+	sleeping->setAlignment(Qt::AlignRight);
+	sleepingCheck = new QCheckBox("Freeze objects at rest", this);
+	sleepingCheck->setChecked(solver->getSleeping());
+
+	// contact solve
+	QLabel* contacts = new QLabel("Contacts", this);
+	contacts->setAlignment(Qt::AlignRight);
+	jacobiContactsCheck = new QCheckBox("Gather, then apply (Jacobi)", this);
+	jacobiContactsCheck->setChecked(solver->getJacobiContacts());
+
+	// deterministic runs
+	QLabel* deterministic = new QLabel("Deterministic", this);
+	deterministic->setAlignment(Qt::AlignRight);
+	deterministicCheck = new QCheckBox("Repeat runs exactly", this);
+	deterministicCheck->setChecked(solver->getDeterministic());
+
 	// max objects
 	QLabel* maxObjects = new QLabel("Max. Objects", this);
 	maxObjects->setAlignment(Qt::AlignRight);
@@ -207,12 +238,22 @@ void ControlPanel::initParameter(Solver* solver)
 	QGridLayout* paramInputLayout = new QGridLayout(this);
 	paramInputLayout->addWidget(fps, 0, 0);
 	paramInputLayout->addWidget(substeps, 1, 0);
-	paramInputLayout->addWidget(maxObjects, 2, 0);
-	paramInputLayout->addWidget(g, 3, 0);
+	paramInputLayout->addWidget(adaptive, 2, 0);
+	paramInputLayout->addWidget(minSubsteps, 3, 0);
+	paramInputLayout->addWidget(sleeping, 4, 0);
+	paramInputLayout->addWidget(contacts, 5, 0);
+	paramInputLayout->addWidget(deterministic, 6, 0);
+	paramInputLayout->addWidget(maxObjects, 7, 0);
+	paramInputLayout->addWidget(g, 8, 0);
 	paramInputLayout->addWidget(fpsDropdown, 0, 1);
 	paramInputLayout->addWidget(substepsInput, 1, 1);
-	paramInputLayout->addWidget(maxObjectsInput, 2, 1);
-	paramInputLayout->addWidget(gInput, 3, 1);
+	paramInputLayout->addWidget(adaptiveSubstepsCheck, 2, 1);
+	paramInputLayout->addWidget(minSubstepsInput, 3, 1);
+	paramInputLayout->addWidget(sleepingCheck, 4, 1);
+	paramInputLayout->addWidget(jacobiContactsCheck, 5, 1);
+	paramInputLayout->addWidget(deterministicCheck, 6, 1);
+	paramInputLayout->addWidget(maxObjectsInput, 7, 1);
+	paramInputLayout->addWidget(gInput, 8, 1);
 
 	parameterLayout = new QVBoxLayout(this);
 	parameterLayout->addLayout(paramInputLayout);
@@ -224,10 +265,20 @@ void ControlPanel::initParameter(Solver* solver)
 	QObject::connect(paramApplyButton, SIGNAL(clicked(bool)), this, SLOT(updateParam()));
 	QObject::connect(this, SIGNAL(applyFramerate(int)),    solver, SLOT(setFramerate(int)));
 	QObject::connect(this, SIGNAL(applySubsteps(int)),     solver, SLOT(setSubsteps(int)));
+	QObject::connect(this, SIGNAL(applyAdaptiveSubsteps(bool)), solver, SLOT(setAdaptiveSubsteps(bool)));
+	QObject::connect(this, SIGNAL(applyMinSubsteps(int)),  solver, SLOT(setMinSubsteps(int)));
+	QObject::connect(this, SIGNAL(applySleeping(bool)),    solver, SLOT(setSleeping(bool)));
+	QObject::connect(this, SIGNAL(applyJacobiContacts(bool)), solver, SLOT(setJacobiContacts(bool)));
+	QObject::connect(this, SIGNAL(applyDeterministic(bool)), solver, SLOT(setDeterministic(bool)));
 	QObject::connect(this, SIGNAL(applyMaxObjects(int)),   solver, SLOT(setMaxObjects(int)));
 	QObject::connect(this, SIGNAL(applyGravity(float, float)), solver, SLOT(setGravity(float, float)));
 	// stylesheets for lineedits
 	QObject::connect(substepsInput, &QLineEdit::textChanged, this, [=]() { substepsInput->setStyleSheet(valid); paramStatus->setVisible(false); });
+	QObject::connect(minSubstepsInput, &QLineEdit::textChanged, this, [=]() { minSubstepsInput->setStyleSheet(valid); paramStatus->setVisible(false); });
+	QObject::connect(sleepingCheck, &QCheckBox::toggled, this, [=]() { paramStatus->setVisible(false); });
+	QObject::connect(jacobiContactsCheck, &QCheckBox::toggled, this, [=]() { paramStatus->setVisible(false); });
+	QObject::connect(deterministicCheck, &QCheckBox::toggled, this, [=]() { paramStatus->setVisible(false); });
+	QObject::connect(adaptiveSubstepsCheck, &QCheckBox::toggled, this, [=](bool checked) { minSubstepsInput->setEnabled(checked); paramStatus->setVisible(false); });
 	QObject::connect(maxObjectsInput, &QLineEdit::textChanged, this, [=]() { maxObjectsInput->setStyleSheet(valid); paramStatus->setVisible(false); });
 	QObject::connect(gInput, &VectorInput::textChanged, this, [=]() { gInput->setStyleSheet(valid); paramStatus->setVisible(false); });
 
@@ -240,6 +291,7 @@ void ControlPanel::updateParam()
 {
 	// at least one line edit is empty
 	if (substepsInput->text().length() == 0 ||
+		minSubstepsInput->text().length() == 0 ||
 		maxObjectsInput->text().length() == 0 ||
 		gInput->isIncomplete())
 	{
@@ -247,6 +299,9 @@ void ControlPanel::updateParam()
 		if (substepsInput->text().length() == 0) {
 			substepsInput->setStyleSheet(invalid);
 		}
+		if (minSubstepsInput->text().length() == 0) {
+			minSubstepsInput->setStyleSheet(invalid);
+		}
 		if (maxObjectsInput->text().length() == 0) {
 			maxObjectsInput->setStyleSheet(invalid);
 		}
@@ -260,6 +315,11 @@ void ControlPanel::updateParam()
 	// send values to solver
 	emit applyFramerate(std::stoi(fpsDropdown->currentText().toStdString()));
 	emit applySubsteps(std::stoi(substepsInput->text().toStdString()));
+	emit applyMinSubsteps(std::stoi(minSubstepsInput->text().toStdString()));
+	emit applyAdaptiveSubsteps(adaptiveSubstepsCheck->isChecked());
+	emit applySleeping(sleepingCheck->isChecked());
+	emit applyJacobiContacts(jacobiContactsCheck->isChecked());
+	emit applyDeterministic(deterministicCheck->isChecked());
 	emit applyMaxObjects(std::stoi(maxObjectsInput->text().toStdString()));
 	emit applyGravity(std::stof(gInput->x().toStdString()), std::stof(gInput->y().toStdString()));
 	paramStatus->setVisible(true);
@@ -1,5 +1,7 @@
 #include "../include/Grid.h"
 #include <iostream>
+#include <algorithm>
+#include <cstdlib>
 
 /// <summary>
 /// Constructs a null grid.
@@ -8,6 +10,10 @@ Grid::Grid() {
 	CELL_SIZE = 0;
 	WIDTH = -1;
 	HEIGHT = -1;
+	incremental = true;
+	cellsValid = false;
+	migratedCount = 0;
+	partitionedCount = 0;
 }
 
 /// <summary>
@@ -20,7 +26,11 @@ Grid::Grid(int cellSize, int boundsWidth, int boundsHeight) {
 	CELL_SIZE = cellSize;
 	WIDTH = boundsWidth / CELL_SIZE + 1;
 	HEIGHT = boundsHeight / CELL_SIZE + 1;
-	cells.resize(WIDTH * HEIGHT, std::vector<Circle*>());
+	cellStart.assign(WIDTH * HEIGHT + 1, 0);
+	incremental = true;
+	cellsValid = false;
+	migratedCount = 0;
+	partitionedCount = 0;
 }
 
 /// <summary>
@@ -31,14 +41,18 @@ Grid::Grid(int cellSize, int boundsWidth, int boundsHeight) {
 void Grid::setGridSize(const int boundsWidth, const int boundsHeight) {
 	WIDTH = boundsWidth / CELL_SIZE + 1;
 	HEIGHT = boundsHeight / CELL_SIZE + 1;
-	cells.resize(WIDTH * HEIGHT, std::vector<Circle*>());
+	cellStart.assign(WIDTH * HEIGHT + 1, 0);
+	cellsValid = false;
 }
 
 /// <summary>
 /// Empties all grid cells.
 /// </summary>
 void Grid::resetCells() {
-	for (auto& cell : cells) { cell.clear(); }
+	std::fill(cellStart.begin(), cellStart.end(), 0);
+	std::fill(cellAwake.begin(), cellAwake.end(), 0);
+	cellObjects.clear();
+	cellsValid = false;
 }
 
 /// <summary>
@@ -47,27 +61,190 @@ void Grid::resetCells() {
 /// <param name="pos"></param>
 /// <returns>Cell index, may not be within grid bounds.</returns>
 int Grid::positionToCellIdx(const Vec2D& pos) {
-	return int(pos.y() / CELL_SIZE) + (int(pos.x() / CELL_SIZE) * HEIGHT);
+	return positionToCellIdx(pos.x(), pos.y());
 }
 
 /// <summary>
-/// Takes a list of objects and adds a pointer to each of them to their corresponding cell in the grid.
+/// Takes a position and calculates the cell index that contains the position.
 /// </summary>
-/// <param name="objects"></param>
-void Grid::partitionObjects(std::vector<Circle>& objects) {
-	for (auto& object : objects) {
-		int cellIdx = positionToCellIdx(object.pos);
-		Circle* objPtr = &object;
+/// <param name="x"></param>
+/// <param name="y"></param>
+/// <returns>Cell index, may not be within grid bounds.</returns>
+int Grid::positionToCellIdx(float x, float y) {
+	return int(y / CELL_SIZE) + (int(x / CELL_SIZE) * HEIGHT);
+}
 
-		try {
-			cells.at(cellIdx).push_back(objPtr);
-		}
-		catch (const std::exception& e) {
-			std::cout << "Index Out of Range:\n";
-			std::cout << "\tIndex " + std::to_string(cellIdx) + " in 'cells' vector of size " + std::to_string(cells.size()) + "\n";
-			std::cout << info() + "\n";
+/// <summary>
+/// Brings the cells up to date with the positions of every object.
+/// </summary>
+/// <param name="objects">Objects outside the grid are binned into the nearest edge cell.</param>
+void Grid::partitionObjects(const ParticleStore& objects) {
+	partitionObjects(objects, std::vector<int>());
+}
+
+/// <summary>
+/// Brings the cells up to date with the objects' positions. Every member's cell is computed first;
+/// in incremental mode only the members whose cell changed are then moved, as long as that is
+/// cheaper than a rebuild, and otherwise the cells are rebuilt from the computed indices.
+/// </summary>
+/// <param name="objects">Objects outside the grid are binned into the nearest edge cell.</param>
+/// <param name="members">Ascending indices of the objects to partition, or empty for all objects. Must list the same objects as the previous call for the incremental update to apply.</param>
+void Grid::partitionObjects(const ParticleStore& objects, const std::vector<int>& members) {
+	const int objectCount = objects.size();
+	const bool all = members.empty();
+	const int memberCount = all ? objectCount : int(members.size());
+	const bool tracked = cellsValid && objectCount == int(objectCell.size()) && memberCount == partitionedCount;
+
+	nextCell.resize(objectCount);
+	cellAwake.assign(getCellCount(), 0);
+	migrants.clear();
+
+	// one move shifts every entry between the old and the new slot by one, see moveObject
+	long long moveCost = 0;
+	for (int k = 0; k < memberCount; k++) {
+		int i = all ? k : members[k];
+		int cellIdx = clampedCellIdx(objects.posX[i], objects.posY[i]);
+		nextCell[i] = cellIdx;
+		cellAwake[cellIdx] |= !objects.asleep[i];
+		if (tracked && cellIdx != objectCell[i]) {
+			migrants.push_back(i);
+			moveCost += std::abs(cellStart[cellIdx] - cellStart[objectCell[i]]);
 		}
 	}
+
+	migratedCount = tracked ? int(migrants.size()) : memberCount;
+	partitionedCount = memberCount;
+
+	// a rebuild streams every member twice, so moves only pay off while they are well under that
+	if (incremental && tracked && moveCost <= memberCount / 2) {
+		for (int obj : migrants) { moveObject(obj, nextCell[obj]); }
+	}
+	else rebuildCells(members);
+}
+
+/// <summary>
+/// Cell index of a position, clamped into the grid.
+/// </summary>
+/// <param name="x"></param>
+/// <param name="y"></param>
+int Grid::clampedCellIdx(float x, float y) const {
+	int col = std::min(std::max(int(x / CELL_SIZE), 0), WIDTH - 1);
+	int row = std::min(std::max(int(y / CELL_SIZE), 0), HEIGHT - 1);
+	return row + col * HEIGHT;
+}
+
+/// <summary>
+/// Rebuilds the cells from scratch from <c>nextCell</c> with a counting sort: members are counted
+/// per cell, the counts are prefix-summed into <c>cellStart</c>, and every member index is then
+/// written into its cell's slot in <c>cellObjects</c>. Objects keep ascending index order within a
+/// cell. No per-cell storage is allocated.
+/// </summary>
+/// <param name="members">Ascending indices of the objects to partition, or empty for all objects.</param>
+void Grid::rebuildCells(const std::vector<int>& members) {
+	const int cellCount = getCellCount();
+	const int objectCount = int(nextCell.size());
+	const bool all = members.empty();
+	const int memberCount = all ? objectCount : int(members.size());
+
+	cellStart.assign(cellCount + 1, 0);
+	objectCell.resize(objectCount);
+	objectSlot.resize(objectCount);
+	cellObjects.resize(memberCount);
+
+	// count members per cell, offset by one so the prefix sum below is exclusive
+	for (int k = 0; k < memberCount; k++) {
+		int i = all ? k : members[k];
+		objectCell[i] = nextCell[i];
+		cellStart[objectCell[i] + 1]++;
+	}
+
+	for (int cellIdx = 0; cellIdx < cellCount; cellIdx++) {
+		cellStart[cellIdx + 1] += cellStart[cellIdx];
+	}
+
+	// scatter member indices into their cell ranges
+	cellCursor.assign(cellStart.begin(), cellStart.end() - 1);
+	for (int k = 0; k < memberCount; k++) {
+		int i = all ? k : members[k];
+		int slot = cellCursor[objectCell[i]]++;
+		cellObjects[slot] = i;
+		objectSlot[i] = slot;
+	}
+
+	cellsValid = true;
+}
+
+/// <summary>
+/// Moves one object to another cell. The entries between its old slot and its place in the new
+/// cell shift by one towards the old slot and the boundaries in between shift with them, so every
+/// cell keeps ascending index order and the cells end up exactly as a rebuild would leave them.
+/// </summary>
+/// <param name="obj"></param>
+/// <param name="toCell"></param>
+void Grid::moveObject(int obj, int toCell) {
+	const int fromCell = objectCell[obj];
+	const int slot = objectSlot[obj];
+	auto first = cellObjects.begin() + cellStart[toCell];
+	auto last = cellObjects.begin() + cellStart[toCell + 1];
+	const int place = int(std::lower_bound(first, last, obj) - cellObjects.begin());
+
+	if (toCell > fromCell) {
+		std::rotate(cellObjects.begin() + slot, cellObjects.begin() + slot + 1, cellObjects.begin() + place);
+		for (int cellIdx = fromCell + 1; cellIdx <= toCell; cellIdx++) { cellStart[cellIdx]--; }
+		for (int k = slot; k < place; k++) { objectSlot[cellObjects[k]] = k; }
+	}
+	else {
+		std::rotate(cellObjects.begin() + place, cellObjects.begin() + slot, cellObjects.begin() + slot + 1);
+		for (int cellIdx = toCell + 1; cellIdx <= fromCell; cellIdx++) { cellStart[cellIdx]++; }
+		for (int k = place; k <= slot; k++) { objectSlot[cellObjects[k]] = k; }
+	}
+
+	objectCell[obj] = toCell;
+}
+
+/// <summary>
+/// How scattered the objects are in memory relative to the grid's traversal order: the share of
+/// consecutive entries in <c>cellObjects</c> that are not also consecutive object indices.
+/// </summary>
+/// <returns>0 when objects are stored in cell order, close to 1 when they are in no spatial order.</returns>
+float Grid::getDisorder() const {
+	if (cellObjects.size() < 2) return 0.f;
+	int scattered = 0;
+	for (size_t k = 1; k < cellObjects.size(); k++) {
+		scattered += (cellObjects[k] != cellObjects[k - 1] + 1);
+	}
+	return float(scattered) / float(cellObjects.size() - 1);
+}
+
+/// <summary>
+/// Share of objects that changed cell in the last partition. Objects added since the previous
+/// partition count as migrated.
+/// </summary>
+/// <returns>A value between 0 and 1, or 0 before the first partition.</returns>
+float Grid::getMigrationFraction() const {
+	return partitionedCount > 0 ? float(migratedCount) / float(partitionedCount) : 0.f;
+}
+
+/// <summary>
+/// Getter for the number of cells.
+/// </summary>
+/// <returns><c>WIDTH * HEIGHT</c></returns>
+int Grid::getCellCount() const { return WIDTH * HEIGHT; }
+
+/// <summary>
+/// Getter for the number of objects held by the cells.
+/// </summary>
+/// <returns>The size of <c>cellObjects</c>.</returns>
+int Grid::getObjectCount() const { return int(cellObjects.size()); }
+
+/// <summary>
+/// Takes a cell index and returns the objects partitioned into it.
+/// </summary>
+/// <param name="cellIdx">Must be a value between 0 and <c>grid.WIDTH * grid.HEIGHT - 1</c> inclusive.</param>
+/// <returns>A view into <c>cellObjects</c>, valid until the next partition.</returns>
+CellSpan Grid::getCell(int cellIdx) const {
+	const int* base = cellObjects.data();
+	return CellSpan{ base + cellStart[cellIdx], base + cellStart[cellIdx + 1] };
 }
 
 /// <summary>
@@ -75,25 +252,25 @@ void Grid::partitionObjects(std::vector<Circle>& objects) {
 /// </summary>
 /// <param name="cellIdx">Must be a value between 0 and <c>grid.WIDTH * grid.HEIGHT - 1</c> inclusive.</param>
 /// <returns>true | false</returns>
-bool Grid::isTopRow(int cellIdx) { return (cellIdx % HEIGHT) == (HEIGHT - 1); }
+bool Grid::isTopRow(int cellIdx) const { return (cellIdx % HEIGHT) == (HEIGHT - 1); }
 /// <summary>
 /// Takes a cell index and determines if it is in the bottom-most row.
 /// </summary>
 /// <param name="cellIdx">Must be a value between 0 and <c>grid.WIDTH * grid.HEIGHT - 1</c> inclusive.</param>
 /// <returns>true | false</returns>
-bool Grid::isBottomRow(int cellIdx) { return (cellIdx % HEIGHT) == 0; }
+bool Grid::isBottomRow(int cellIdx) const { return (cellIdx % HEIGHT) == 0; }
 /// <summary>
 /// Takes a cell index and determines if it is in the left-most column.
 /// </summary>
 /// <param name="cellIdx">Must be a value between 0 and <c>grid.WIDTH * grid.HEIGHT - 1</c> inclusive.</param>
 /// <returns>true | false</returns>
-bool Grid::isLeftCol(int cellIdx) { return cellIdx < HEIGHT; }
+bool Grid::isLeftCol(int cellIdx) const { return cellIdx < HEIGHT; }
 /// <summary>
 /// Takes a cell index and determines if it is in the right-most column.
 /// </summary>
 /// <param name="cellIdx">Must be a value between 0 and <c>grid.WIDTH * grid.HEIGHT - 1</c> inclusive.</param>
 /// <returns>true | false</returns>
-bool Grid::isRightCol(int cellIdx) { return cellIdx >= (cells.size() - HEIGHT); }
+bool Grid::isRightCol(int cellIdx) const { return cellIdx >= (getCellCount() - HEIGHT); }
 
 /// <summary>
 /// Converts the grid to string format.
@@ -105,7 +282,7 @@ std::string Grid::toString() {
 	for (int i = HEIGHT - 1; i >= 0; i--) {
 		gridString += "\n[ ";
 		for (int j = i; j <= HEIGHT * (WIDTH - 1) + i; j += HEIGHT) {
-			gridString += std::to_string(cells.at(j).size()) + " ";
+			gridString += std::to_string(getCell(j).size()) + " ";
 		}
 		gridString += "]";
 	}
@@ -116,7 +293,7 @@ std::string Grid::info() {
 	std::string gridString("");
 
 	gridString += "Cell size: " + std::to_string(CELL_SIZE) + "\n";
-	gridString += "Cell count: " + std::to_string(cells.size()) + "\n";
+	gridString += "Cell count: " + std::to_string(getCellCount()) + "\n";
 	gridString += "Dimensions:\n\tw: " + std::to_string(WIDTH) + "\th: " + std::to_string(HEIGHT);
 
 	return gridString;
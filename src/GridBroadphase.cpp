@@ -0,0 +1,311 @@
+#include "../include/GridBroadphase.h"
+#include <algorithm>
+#include <cmath>
+
+/// <summary>
+/// Getter for the grid levels, also used by the solver's sleep and reorder passes.
+/// </summary>
+GridHierarchy& GridBroadphase::getGrids() { return grids; }
+const GridHierarchy& GridBroadphase::getGrids() const { return grids; }
+
+const char* GridBroadphase::getName() const { return "grid"; }
+
+/// <summary>
+/// Sizes the grid levels for a radius range, see <c>GridHierarchy::setRadiusRange</c>.
+/// </summary>
+void GridBroadphase::setRadiusRange(int minRadius, int maxRadius) { grids.setRadiusRange(minRadius, maxRadius); }
+
+/// <summary>
+/// Partitions the objects into the grid levels.
+/// </summary>
+/// <param name="objects"></param>
+void GridBroadphase::update(const ParticleStore& objects) { grids.partitionObjects(objects); }
+
+/// <summary>
+/// Empties the grid levels, so the next update starts from scratch.
+/// </summary>
+void GridBroadphase::reset() { grids.resetCells(); }
+
+float GridBroadphase::getMigrationFraction() const { return grids.getMigrationFraction(); }
+float GridBroadphase::getDisorder() const { return grids.getDisorder(); }
+void GridBroadphase::getTraversalOrder(std::vector<int>& order) const { grids.getTraversalOrder(order); }
+
+/// <summary>
+/// Resolves collisions within each grid level on column stripes of the worker pool, and then the
+/// pairs that span two levels.
+/// </summary>
+/// <param name="objects">The objects of the last <c>update</c>, read again for current positions.</param>
+/// <param name="workers"></param>
+/// <param name="resolve"></param>
+void GridBroadphase::collide(const ParticleStore& objects, WorkerPool& workers, const BatchResolver& resolve)
+{
+    prepareBatches(workers);
+
+    for (int level = 0; level < grids.getLevelCount(); level++) {
+        if (grids.getLevel(level).getObjectCount() > 0) collideLevel(grids.getLevel(level), objects, workers, resolve);
+    }
+    if (grids.getLevelCount() > 1) collideAcrossLevels(objects, workers, resolve);
+}
+
+/// <summary>
+/// Resolves collisions between the objects of one grid level, in parallel over column stripes.
+/// </summary>
+/// <param name="grid">One level of <c>grids</c>, already partitioned.</param>
+/// <param name="objects"></param>
+/// <param name="workers"></param>
+/// <param name="resolve"></param>
+void GridBroadphase::collideLevel(const Grid& grid, const ParticleStore& objects, WorkerPool& workers, const BatchResolver& resolve)
+{
+    /*
+    Columns are grouped into stripes of STRIPE_WIDTH. A kernel reaches one
+    column past the right edge of its stripe, so stripes of the same colour
+    (every other stripe) never share objects and can run concurrently.
+    Colours run one after the other with the pool's join as the barrier.
+    Stripe boundaries do not depend on the thread count, so every thread
+    count produces the same result.
+    */
+    int stripeCount = (grid.WIDTH + STRIPE_WIDTH - 1) / STRIPE_WIDTH;
+    int threadCount = workers.getThreadCount();
+
+    for (int colour = 0; colour < 2; colour++) {
+        int colourStripeCount = (stripeCount - colour + 1) / 2;
+
+        // objects pile up in a few columns, so stripes are shared out by the work in them, not by count
+        std::vector<long long>& workPrefix = stripeWork[colour];
+        workPrefix.assign(1, 0);
+        if (threadCount > 1) {
+            for (int k = 0; k < colourStripeCount; k++) {
+                int startCol = (2 * k + colour) * STRIPE_WIDTH;
+                int endCol = std::min(startCol + STRIPE_WIDTH, grid.WIDTH);
+                long long work = 0;
+                for (int cellIdx = startCol * grid.HEIGHT; cellIdx < endCol * grid.HEIGHT; cellIdx++) {
+                    work += kernelWork(grid, cellIdx);
+                }
+                workPrefix.push_back(workPrefix.back() + work);
+            }
+        }
+
+        // each worker takes one contiguous run of this colour's stripes
+        workers.run([&](int thread) {
+            int first = 0;
+            int last = colourStripeCount;
+            if (threadCount > 1) splitByWork(workPrefix, thread, threadCount, first, last);
+            for (int k = first; k < last; k++) {
+                int startCol = (2 * k + colour) * STRIPE_WIDTH;
+                int endCol = std::min(startCol + STRIPE_WIDTH, grid.WIDTH);
+                collideStripe(grid, startCol * grid.HEIGHT, endCol * grid.HEIGHT, objects, thread, resolve);
+            }
+        });
+    }
+}
+
+/// <summary>
+/// Visits every pair of objects within <c>slack</c> of touching once: within a level with the half
+/// stencil of <c>collideStripe</c>, grown by as many cells as the slack carries a pair past adjacent
+/// cells, and then across levels.
+/// </summary>
+/// <param name="objects">The objects of the last <c>update</c>.</param>
+/// <param name="slack">Gap, in px, still counted as near.</param>
+/// <param name="visit"></param>
+void GridBroadphase::forEachNearPair(const ParticleStore& objects, float slack, const PairVisitor& visit)
+{
+    for (int level = 0; level < grids.getLevelCount(); level++) {
+        const Grid& grid = grids.getLevel(level);
+        if (grid.getObjectCount() == 0) continue;
+
+        // centres of a near pair in one level are at most a cell and the slack apart
+        int span = std::max(int(std::ceil((float(grid.CELL_SIZE) + slack) / float(grid.CELL_SIZE))), 1);
+
+        for (int cellIdx = 0; cellIdx < grid.getCellCount(); cellIdx++) {
+            CellSpan cell = grid.getCell(cellIdx);
+            if (cell.empty()) continue;
+
+            int col = cellIdx / grid.HEIGHT;
+            int row = cellIdx % grid.HEIGHT;
+            int rowLo = std::max(row - span, 0);
+            int rowHi = std::min(row + span, grid.HEIGHT - 1);
+            int colHi = std::min(col + span, grid.WIDTH - 1);
+
+            // the rest of the cell and the cells above it, then the rows in reach of each next column,
+            // are each one contiguous range
+            const int* aboveEnd = grid.getCell(col * grid.HEIGHT + rowHi).end();
+            for (const int* obj = cell.begin(); obj != cell.end(); obj++) {
+                for (const int* other = obj + 1; other != aboveEnd; other++) { visit(*obj, *other); }
+                for (int right = col + 1; right <= colHi; right++) {
+                    const int* end = grid.getCell(right * grid.HEIGHT + rowHi).end();
+                    for (const int* other = grid.getCell(right * grid.HEIGHT + rowLo).begin(); other != end; other++) { visit(*obj, *other); }
+                }
+            }
+        }
+
+        // pairs across levels, from the larger object as in the collision pass
+        for (int obj : grid.cellObjects) {
+            grids.forEachFinerSpan(level, objects.posX[obj], objects.posY[obj], objects.radius[obj] + slack, [&](CellSpan span) {
+                for (int other : span) { visit(obj, other); }
+            });
+        }
+    }
+}
+
+/// <summary>
+/// Resolves collisions between objects of different grid levels. Every object of a coarser level is
+/// tested against the objects of the finer levels within reach of it, so each cross-level pair is
+/// tested once, from its larger object. Coarse objects are scheduled in two colours of column
+/// stripes like <c>collideLevel</c>, with stripes wide enough that queries from stripes of the same
+/// colour never visit the same finer cell.
+/// </summary>
+/// <param name="objects"></param>
+/// <param name="workers"></param>
+/// <param name="resolve"></param>
+void GridBroadphase::collideAcrossLevels(const ParticleStore& objects, WorkerPool& workers, const BatchResolver& resolve)
+{
+    const float* posX = objects.posX.data();
+    const float* posY = objects.posY.data();
+    const float* radius = objects.radius.data();
+    int threadCount = workers.getThreadCount();
+
+    for (int level = 1; level < grids.getLevelCount(); level++) {
+        const Grid& grid = grids.getLevel(level);
+        if (grid.getObjectCount() == 0) continue;
+
+        // a query visits finer cells up to its reach from its centre, so a stripe wider than two
+        // reaches keeps the stripe after next out of range; the coarsest level may hold objects
+        // larger than its bound, so the reach is taken from the objects themselves
+        float reach = 0.f;
+        for (int obj : grid.cellObjects) { reach = std::max(reach, radius[obj]); }
+        reach += grids.getFinerMargin(level);
+        int stripeWidth = int(2.f * reach / float(grid.CELL_SIZE)) + 1;
+        int stripeCount = (grid.WIDTH + stripeWidth - 1) / stripeWidth;
+
+        for (int colour = 0; colour < 2; colour++) {
+            int colourStripeCount = (stripeCount - colour + 1) / 2;
+
+            // coarse objects are few and unevenly spread, so stripes are shared out by their count
+            std::vector<long long>& workPrefix = stripeWork[colour];
+            workPrefix.assign(1, 0);
+            if (threadCount > 1) {
+                for (int k = 0; k < colourStripeCount; k++) {
+                    int startCol = (2 * k + colour) * stripeWidth;
+                    int endCol = std::min(startCol + stripeWidth, grid.WIDTH);
+                    long long count = grid.getCell(endCol * grid.HEIGHT - 1).end() - grid.getCell(startCol * grid.HEIGHT).begin();
+                    workPrefix.push_back(workPrefix.back() + count);
+                }
+            }
+
+            workers.run([&](int thread) {
+                CandidateBatch& batch = threadBatches[thread].batch;
+                int first = 0;
+                int last = colourStripeCount;
+                if (threadCount > 1) splitByWork(workPrefix, thread, threadCount, first, last);
+                for (int k = first; k < last; k++) {
+                    int startCol = (2 * k + colour) * stripeWidth;
+                    int endCol = std::min(startCol + stripeWidth, grid.WIDTH);
+                    float minX = float(startCol * grid.CELL_SIZE);
+                    float maxX = float(endCol * grid.CELL_SIZE);
+
+                    // the columns of a stripe are consecutive cells, so their objects form one contiguous range
+                    const int* end = grid.getCell(endCol * grid.HEIGHT - 1).end();
+                    for (const int* it = grid.getCell(startCol * grid.HEIGHT).begin(); it != end; it++) {
+                        int obj = *it;
+
+                        // the coarse object takes lane 0, followed by every finer object near it; the
+                        // query stays inside the stripe even when the object has drifted out of it
+                        batch.clear();
+                        batch.gather(&obj, &obj + 1, posX, posY, radius);
+                        float queryX = std::clamp(posX[obj], minX, maxX);
+                        grids.forEachFinerSpan(level, queryX, posY[obj], radius[obj], [&](CellSpan span) {
+                            batch.gather(span.begin(), span.end(), posX, posY, radius);
+                        });
+                        batch.seal();
+                        resolve(thread, batch, 1);
+                    }
+                }
+            });
+        }
+    }
+}
+
+/// <summary>
+/// Hands each cell of a stripe to the resolver, followed by the forward half of its neighbourhood
+/// (the cell above it and the three cells in the next column), so every pair of objects in adjacent
+/// cells is tested exactly once.
+/// </summary>
+/// <param name="grid">The grid level being tested.</param>
+/// <param name="startCellIdx">Always in the bottom row of cells by design.</param>
+/// <param name="endCellIdx">Always in the top row of cells by design.</param>
+/// <param name="objects"></param>
+/// <param name="thread">Index of the calling worker.</param>
+/// <param name="resolve"></param>
+void GridBroadphase::collideStripe(const Grid& grid, int startCellIdx, int endCellIdx, const ParticleStore& objects, int thread, const BatchResolver& resolve)
+{
+    CandidateBatch& batch = threadBatches[thread].batch;
+
+    const float* posX = objects.posX.data();
+    const float* posY = objects.posY.data();
+    const float* radius = objects.radius.data();
+    auto addCells = [&](int firstCellIdx, int lastCellIdx) {
+        // consecutive cells are adjacent in cellObjects, so they form one contiguous range
+        batch.gather(grid.getCell(firstCellIdx).begin(), grid.getCell(lastCellIdx).end(), posX, posY, radius);
+    };
+
+    for (int cellIdx = startCellIdx; cellIdx < endCellIdx; cellIdx++) {
+        int cellSize = grid.getCell(cellIdx).size();
+        if (cellSize == 0 || !isKernelAwake(grid, cellIdx)) continue;
+
+        // gather the cell itself, then the forward half of the kernel
+        bool hasUp = !grid.isTopRow(cellIdx);
+        bool hasDown = !grid.isBottomRow(cellIdx);
+        bool hasRight = !grid.isRightCol(cellIdx);
+
+        batch.clear();
+        addCells(cellIdx, hasUp ? cellIdx + 1 : cellIdx);
+        if (hasRight) {
+            addCells(hasDown ? cellIdx + grid.HEIGHT - 1 : cellIdx + grid.HEIGHT,
+                     hasUp ? cellIdx + grid.HEIGHT + 1 : cellIdx + grid.HEIGHT);
+        }
+        batch.seal();
+        resolve(thread, batch, cellSize);
+    }
+}
+
+/// <summary>
+/// Whether any cell of a kernel holds an awake object. A kernel with no awake object has nothing
+/// to resolve.
+/// </summary>
+/// <param name="grid"></param>
+/// <param name="cellIdx">The cell the kernel belongs to.</param>
+bool GridBroadphase::isKernelAwake(const Grid& grid, int cellIdx)
+{
+    bool hasUp = !grid.isTopRow(cellIdx);
+    bool hasDown = !grid.isBottomRow(cellIdx);
+    const std::uint8_t* cellAwake = grid.cellAwake.data();
+
+    bool kernelAwake = cellAwake[cellIdx] || (hasUp && cellAwake[cellIdx + 1]);
+    if (!grid.isRightCol(cellIdx)) {
+        int right = cellIdx + grid.HEIGHT;
+        kernelAwake = kernelAwake || cellAwake[right] || (hasDown && cellAwake[right - 1]) || (hasUp && cellAwake[right + 1]);
+    }
+    return kernelAwake;
+}
+
+/// <summary>
+/// Estimated cost of resolving a cell's kernel: the lane tests <c>collideStripe</c> hands to the
+/// resolver for it, the cell's objects times the objects gathered with them.
+/// </summary>
+/// <param name="grid"></param>
+/// <param name="cellIdx">The cell the kernel belongs to.</param>
+/// <returns>0 when the kernel is skipped.</returns>
+long long GridBroadphase::kernelWork(const Grid& grid, int cellIdx)
+{
+    int cellSize = grid.getCell(cellIdx).size();
+    if (cellSize == 0 || !isKernelAwake(grid, cellIdx)) return 0;
+
+    bool hasUp = !grid.isTopRow(cellIdx);
+    bool hasDown = !grid.isBottomRow(cellIdx);
+    int kernelSize = int(grid.getCell(hasUp ? cellIdx + 1 : cellIdx).end() - grid.getCell(cellIdx).begin());
+    if (!grid.isRightCol(cellIdx)) {
+        int right = cellIdx + grid.HEIGHT;
+        kernelSize += int(grid.getCell(hasUp ? right + 1 : right).end() - grid.getCell(hasDown ? right - 1 : right).begin());
+    }
+    return (long long)cellSize * kernelSize;
+}
@@ -0,0 +1,210 @@
+#include "../include/GridHierarchy.h"
+#include "../include/Objects.h"
+
+/// <summary>
+/// Constructs an empty hierarchy covering no area.
+/// </summary>
+GridHierarchy::GridHierarchy() : GridHierarchy(0, 0) {}
+
+/// <summary>
+/// Constructs a hierarchy covering the given area, for objects of <c>Circle</c>'s default radius range.
+/// The levels are built on the first partition, and rebuilt whenever the range changes.
+/// </summary>
+/// <param name="boundsWidth">The width of the area the grids cover, in pixels.</param>
+/// <param name="boundsHeight">The height of the area the grids cover, in pixels.</param>
+GridHierarchy::GridHierarchy(int boundsWidth, int boundsHeight) {
+	this->boundsWidth = boundsWidth;
+	this->boundsHeight = boundsHeight;
+	assignedCount = -1;
+	minRadius = Circle::DEFAULT_MIN_RADIUS;
+	maxRadius = Circle::DEFAULT_MAX_RADIUS;
+	builtMinRadius = 0;
+	builtMaxRadius = 0;
+	builtMultiLevel = false;
+	incremental = true;
+	multiLevel = true;
+}
+
+/// <summary>
+/// Takes a width and height and updates every level's dimensions accordingly.
+/// </summary>
+/// <param name="boundsWidth">The width of the area the grids cover, in pixels.</param>
+/// <param name="boundsHeight">The height of the area the grids cover, in pixels.</param>
+void GridHierarchy::setGridSize(const int boundsWidth, const int boundsHeight) {
+	this->boundsWidth = boundsWidth;
+	this->boundsHeight = boundsHeight;
+	for (Grid& grid : levels) { grid.setGridSize(boundsWidth, boundsHeight); }
+}
+
+/// <summary>
+/// Sets the radius range of the objects. The levels are rebuilt for it on the next partition if it changed.
+/// </summary>
+/// <param name="minRadius"></param>
+/// <param name="maxRadius">Must be at least <c>minRadius</c>.</param>
+void GridHierarchy::setRadiusRange(int minRadius, int maxRadius) {
+	this->minRadius = minRadius;
+	this->maxRadius = maxRadius;
+}
+
+/// <summary>
+/// Empties every level. Objects are assigned to levels again on the next partition, so this must be
+/// called whenever objects are reordered in memory.
+/// </summary>
+void GridHierarchy::resetCells() {
+	for (Grid& grid : levels) { grid.resetCells(); }
+	assignedCount = -1;
+}
+
+/// <summary>
+/// Builds the levels for the current radius range. Level 0 takes radii up to twice the minimum and each
+/// level after it <c>LEVEL_RATIO</c> times more, up to the maximum radius; a ratio of two was measured
+/// to spend more on cross-level queries than it saved. Cells span the largest diameter of their level, so the 3x3
+/// kernel reaches every object that can touch. A range of less than a factor of two, or <c>multiLevel</c>
+/// switched off, gives a single level for the maximum radius.
+/// </summary>
+void GridHierarchy::buildLevels() {
+	builtMinRadius = minRadius;
+	builtMaxRadius = maxRadius;
+	builtMultiLevel = multiLevel;
+
+	levels.clear();
+	levelRadius.clear();
+	int radius = multiLevel ? std::min(2 * minRadius, maxRadius) : maxRadius;
+	while (true) {
+		levelRadius.push_back(radius);
+		if (radius >= maxRadius) break;
+		radius = std::min(LEVEL_RATIO * radius, maxRadius);
+	}
+
+	for (int bound : levelRadius) { levels.emplace_back(std::max(2 * bound, 1), boundsWidth, boundsHeight); }
+	levelMembers.assign(levels.size(), std::vector<int>());
+	assignedCount = -1;
+}
+
+/// <summary>
+/// Bins every object into the finest level whose radius bound is at least its radius. Objects larger
+/// than the maximum radius, spawned before it was lowered, go into the coarsest level.
+/// </summary>
+/// <param name="objects"></param>
+void GridHierarchy::assignLevels(const ParticleStore& objects) {
+	const int objectCount = objects.size();
+	const int levelCount = getLevelCount();
+
+	for (auto& members : levelMembers) { members.clear(); }
+
+	if (levelCount > 1) {
+		for (int i = 0; i < objectCount; i++) {
+			int level = 0;
+			while (level < levelCount - 1 && float(levelRadius[level]) < objects.radius[i]) level++;
+			levelMembers[level].push_back(i);
+		}
+	}
+
+	// membership changed, so no level can be updated incrementally
+	for (Grid& grid : levels) { grid.resetCells(); }
+	assignedCount = objectCount;
+}
+
+/// <summary>
+/// Brings every level up to date with the objects' positions, rebuilding the levels first if the
+/// radius range has changed and reassigning objects to levels if objects were added or removed.
+/// </summary>
+/// <param name="objects"></param>
+void GridHierarchy::partitionObjects(const ParticleStore& objects) {
+	if (levels.empty() || builtMinRadius != minRadius || builtMaxRadius != maxRadius || builtMultiLevel != multiLevel) {
+		buildLevels();
+	}
+	if (assignedCount != objects.size()) assignLevels(objects);
+
+	if (getLevelCount() == 1) {
+		levels[0].incremental = incremental;
+		levels[0].partitionObjects(objects);
+		return;
+	}
+
+	for (int level = 0; level < getLevelCount(); level++) {
+		Grid& grid = levels[level];
+		grid.incremental = incremental;
+
+		// an empty member list means every object to Grid, so empty levels are only cleared
+		if (levelMembers[level].empty()) {
+			if (grid.getObjectCount() > 0) grid.resetCells();
+		}
+		else grid.partitionObjects(objects, levelMembers[level]);
+	}
+}
+
+/// <summary>
+/// Getter for the width of the area the grids cover.
+/// </summary>
+/// <returns>The width last passed to <c>setGridSize</c>, in pixels.</returns>
+int GridHierarchy::getWidth() const { return boundsWidth; }
+
+/// <summary>
+/// Getter for the height of the area the grids cover.
+/// </summary>
+/// <returns>The height last passed to <c>setGridSize</c>, in pixels.</returns>
+int GridHierarchy::getHeight() const { return boundsHeight; }
+
+/// <summary>
+/// Getter for the number of levels.
+/// </summary>
+/// <returns>At least 1 once objects have been partitioned, 0 before.</returns>
+int GridHierarchy::getLevelCount() const { return int(levels.size()); }
+
+/// <summary>
+/// Takes a level index and returns its grid.
+/// </summary>
+/// <param name="level">Must be a value between 0 and <c>getLevelCount() - 1</c> inclusive.</param>
+const Grid& GridHierarchy::getLevel(int level) const { return levels[level]; }
+
+/// <summary>
+/// How far past a query's reach <c>forEachFinerSpan</c> may visit finer cells: the radius bound of
+/// the level below plus one of its cells, the coarsest of the finer levels.
+/// </summary>
+/// <param name="level">Level of the querying object. Must be at least 1.</param>
+/// <returns>Distance along either axis, in px.</returns>
+float GridHierarchy::getFinerMargin(int level) const {
+	return float(levelRadius[level - 1]) + float(levels[level - 1].CELL_SIZE);
+}
+
+/// <summary>
+/// Share of objects that changed cell in the last partition, over all levels.
+/// </summary>
+/// <returns>A value between 0 and 1, or 0 before the first partition.</returns>
+float GridHierarchy::getMigrationFraction() const {
+	float migrated = 0.f;
+	int total = 0;
+	for (const Grid& grid : levels) {
+		migrated += grid.getMigrationFraction() * float(grid.getObjectCount());
+		total += grid.getObjectCount();
+	}
+	return total > 0 ? migrated / float(total) : 0.f;
+}
+
+/// <summary>
+/// How scattered the objects are in memory relative to the traversal order, weighted over all levels.
+/// See <c>Grid::getDisorder</c>.
+/// </summary>
+/// <returns>0 when objects are stored in traversal order, close to 1 when they are in no spatial order.</returns>
+float GridHierarchy::getDisorder() const {
+	float disorder = 0.f;
+	int total = 0;
+	for (const Grid& grid : levels) {
+		disorder += grid.getDisorder() * float(grid.getObjectCount());
+		total += grid.getObjectCount();
+	}
+	return total > 0 ? disorder / float(total) : 0.f;
+}
+
+/// <summary>
+/// Lists every object in the order the collision pass visits them: level by level from the finest,
+/// and by cell within each level.
+/// </summary>
+/// <param name="order">Overwritten with a permutation of the object indices from the last partition.</param>
+void GridHierarchy::getTraversalOrder(std::vector<int>& order) const {
+	order.clear();
+	for (const Grid& grid : levels) {
+		order.insert(order.end(), grid.cellObjects.begin(), grid.cellObjects.end());
+	}
+}
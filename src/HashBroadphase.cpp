@@ -0,0 +1,373 @@
+#include "../include/HashBroadphase.h"
+#include "../include/Objects.h"
+#include <algorithm>
+#include <cmath>
+
+/// <summary>
+/// Constructs an empty hash grid for <c>Circle</c>'s default radius range.
+/// </summary>
+HashBroadphase::HashBroadphase()
+{
+    maxRadius = Circle::DEFAULT_MAX_RADIUS;
+    cellSize = 0.f;
+    invCellSize = 0.f;
+    slotMask = 0;
+    migratedCount = 0;
+}
+
+const char* HashBroadphase::getName() const { return "hash"; }
+
+/// <summary>
+/// Sizes the cells for a radius range. The cells are rebuilt on the next update if the maximum changed.
+/// </summary>
+void HashBroadphase::setRadiusRange(int, int maxRadius) { this->maxRadius = maxRadius; }
+
+/// <summary>
+/// Forgets every object's cell, so the next update counts every object as migrated. Must be called
+/// whenever objects are reordered in memory.
+/// </summary>
+void HashBroadphase::reset() { objectKey.clear(); }
+
+/// <summary>
+/// Packs cell coordinates into a key that sorts by column, then by row.
+/// </summary>
+/// <param name="col"></param>
+/// <param name="row"></param>
+std::uint64_t HashBroadphase::makeKey(int col, int row)
+{
+    // flipping the sign bit makes unsigned order match signed order
+    return (std::uint64_t(std::uint32_t(col) ^ 0x80000000u) << 32) | (std::uint32_t(row) ^ 0x80000000u);
+}
+
+int HashBroadphase::keyCol(std::uint64_t key) { return int(std::uint32_t(key >> 32) ^ 0x80000000u); }
+int HashBroadphase::keyRow(std::uint64_t key) { return int(std::uint32_t(key) ^ 0x80000000u); }
+
+/// <summary>
+/// Stripe of a cell column, rounding down for negative columns too.
+/// </summary>
+/// <param name="col"></param>
+int HashBroadphase::stripeOf(int col) { return col >= 0 ? col / STRIPE_WIDTH : -((-col + STRIPE_WIDTH - 1) / STRIPE_WIDTH); }
+
+/// <summary>
+/// Takes a position along either axis and returns the cell coordinate containing it.
+/// </summary>
+/// <param name="pos"></param>
+/// <returns>A coordinate clamped to <c>MAX_COORD</c> either side of 0, so far-flung objects share the edge cells.</returns>
+int HashBroadphase::coord(float pos) const
+{
+    float cell = std::clamp(pos * invCellSize, -float(MAX_COORD), float(MAX_COORD));
+    int truncated = int(cell);
+    return truncated - (cell < float(truncated));     // round towards negative infinity
+}
+
+/// <summary>
+/// Probes the table for a key.
+/// </summary>
+/// <param name="key"></param>
+/// <returns>The slot holding the key, or the empty slot where it would go.</returns>
+int HashBroadphase::findSlot(std::uint64_t key) const
+{
+    // Fibonacci hashing spreads neighbouring cells over the table
+    int slot = int((key * 0x9E3779B97F4A7C15ull) >> 32) & slotMask;
+    while (slots[slot].cell >= 0 && slots[slot].key != key) { slot = (slot + 1) & slotMask; }
+    return slot;
+}
+
+/// <summary>
+/// Looks up an occupied cell by its coordinates.
+/// </summary>
+/// <param name="col"></param>
+/// <param name="row"></param>
+/// <returns>Index of the cell, or -1 when no object is in it.</returns>
+int HashBroadphase::findCell(int col, int row) const
+{
+    if (slots.empty()) return -1;
+    return slots[findSlot(makeKey(col, row))].cell;
+}
+
+/// <summary>
+/// Brings the cells up to date with the positions of every object. Objects are radix sorted by cell
+/// in time linear in the object count, runs of objects in the same cell become the occupied cells,
+/// and only those are entered into the table.
+/// </summary>
+/// <param name="objects"></param>
+void HashBroadphase::update(const ParticleStore& objects)
+{
+    const int objectCount = objects.size();
+    const float* posX = objects.posX.data();
+    const float* posY = objects.posY.data();
+
+    // cells span the largest diameter, so the kernel reaches every pair that can touch; a new radius
+    // range changes every cell, so start from scratch
+    float newCellSize = float(std::max(2 * maxRadius, 1));
+    if (newCellSize != cellSize) {
+        cellSize = newCellSize;
+        invCellSize = 1.f / cellSize;
+        objectKey.clear();
+    }
+
+    // objects kept from the last update count as migrated only if their cell changed
+    int trackedCount = int(objectKey.size()) <= objectCount ? int(objectKey.size()) : 0;
+    migratedCount = objectCount - trackedCount;
+    objectKey.resize(objectCount);
+    int minCol = MAX_COORD, maxCol = -MAX_COORD, minRow = MAX_COORD, maxRow = -MAX_COORD;
+    for (int i = 0; i < objectCount; i++) {
+        int col = coord(posX[i]);
+        int row = coord(posY[i]);
+        std::uint64_t key = makeKey(col, row);
+        if (i < trackedCount && objectKey[i] != key) migratedCount++;
+        objectKey[i] = key;
+        minCol = std::min(minCol, col);
+        maxCol = std::max(maxCol, col);
+        minRow = std::min(minRow, row);
+        maxRow = std::max(maxRow, row);
+    }
+
+    // offsets from the occupied corner sort the same as the keys but span only the occupied area,
+    // so a few radix passes from index order sort by cell and leave each cell in index order
+    std::uint64_t rowSpan = std::uint64_t(std::int64_t(maxRow) - minRow + 1);
+    std::uint64_t maxRank = 0;
+    entryKey.resize(objectCount);
+    cellObjects.resize(objectCount);
+    for (int i = 0; i < objectCount; i++) {
+        std::uint64_t rank = std::uint64_t(std::int64_t(keyCol(objectKey[i])) - minCol) * rowSpan
+            + std::uint64_t(std::int64_t(keyRow(objectKey[i])) - minRow);
+        entryKey[i] = rank;
+        cellObjects[i] = i;
+        maxRank = std::max(maxRank, rank);
+    }
+
+    const int radix = 1 << RADIX_BITS;
+    sortKeyScratch.resize(objectCount);
+    sortObjectScratch.resize(objectCount);
+    for (int shift = 0; shift < 64 && (maxRank >> shift) != 0; shift += RADIX_BITS) {
+        digitStart.assign(radix + 1, 0);
+        for (int k = 0; k < objectCount; k++) { digitStart[((entryKey[k] >> shift) & (radix - 1)) + 1]++; }
+        for (int d = 0; d < radix; d++) { digitStart[d + 1] += digitStart[d]; }
+        for (int k = 0; k < objectCount; k++) {
+            int slot = digitStart[(entryKey[k] >> shift) & (radix - 1)]++;
+            sortKeyScratch[slot] = entryKey[k];
+            sortObjectScratch[slot] = cellObjects[k];
+        }
+        entryKey.swap(sortKeyScratch);
+        cellObjects.swap(sortObjectScratch);
+    }
+
+    // each run of equal ranks is one occupied cell
+    cellKey.clear();
+    cellStart.clear();
+    for (int k = 0; k < objectCount; k++) {
+        if (k > 0 && entryKey[k] == entryKey[k - 1]) continue;
+        cellKey.push_back(objectKey[cellObjects[k]]);
+        cellStart.push_back(k);
+    }
+    const int cellTotal = int(cellKey.size());
+    cellStart.push_back(objectCount);
+
+    int capacity = 16;
+    while (capacity < 2 * cellTotal) { capacity *= 2; }
+    slots.assign(capacity, Slot{ 0, -1 });
+    slotMask = capacity - 1;
+    for (int cell = 0; cell < cellTotal; cell++) { slots[findSlot(cellKey[cell])] = Slot{ cellKey[cell], cell }; }
+
+    cellAwake.assign(cellTotal, 0);
+    for (int cell = 0; cell < cellTotal; cell++) {
+        for (int k = cellStart[cell]; k < cellStart[cell + 1]; k++) { cellAwake[cell] |= !objects.asleep[cellObjects[k]]; }
+    }
+
+    // runs of cells in the same stripe, dealt out to the two colours
+    stripeStart.clear();
+    colourStripes[0].clear();
+    colourStripes[1].clear();
+    int previousStripe = 0;
+    for (int cell = 0; cell < cellTotal; cell++) {
+        int stripe = stripeOf(keyCol(cellKey[cell]));
+        if (cell > 0 && stripe == previousStripe) continue;
+        colourStripes[stripe & 1].push_back(int(stripeStart.size()));
+        stripeStart.push_back(cell);
+        previousStripe = stripe;
+    }
+    stripeStart.push_back(cellTotal);
+}
+
+/// <summary>
+/// Finds the cells of a cell's kernel: the cell above it and the three cells in the next column, the
+/// forward half of its neighbourhood. Cells are in column order, so each part is a run of consecutive
+/// cells.
+/// </summary>
+/// <param name="cell"></param>
+/// <param name="upperCell">Set to the cell above if it is occupied, otherwise to <c>cell</c>.</param>
+/// <param name="rightFirst">Set to the first occupied cell of the next column's three, or -1 if none is.</param>
+/// <param name="rightLast">Set to the last occupied cell of the next column's three.</param>
+void HashBroadphase::findKernel(int cell, int& upperCell, int& rightFirst, int& rightLast) const
+{
+    int col = keyCol(cellKey[cell]);
+    int row = keyRow(cellKey[cell]);
+
+    upperCell = (cell + 1 < int(cellKey.size()) && cellKey[cell + 1] == makeKey(col, row + 1)) ? cell + 1 : cell;
+
+    rightFirst = -1;
+    rightLast = -1;
+    for (int dy = -1; dy <= 1; dy++) {
+        int right = findCell(col + 1, row + dy);
+        if (right < 0) continue;
+        if (rightFirst < 0) rightFirst = right;
+        rightLast = right;
+    }
+}
+
+/// <summary>
+/// Whether any cell of a kernel found by <c>findKernel</c> holds an awake object. A kernel with no
+/// awake object has nothing to resolve.
+/// </summary>
+bool HashBroadphase::isKernelAwake(int cell, int upperCell, int rightFirst, int rightLast) const
+{
+    if (cellAwake[cell] || cellAwake[upperCell]) return true;
+    for (int k = rightFirst; k >= 0 && k <= rightLast; k++) {
+        if (cellAwake[k]) return true;
+    }
+    return false;
+}
+
+/// <summary>
+/// Estimated cost of resolving a cell's kernel, as in <c>GridBroadphase::kernelWork</c>.
+/// </summary>
+/// <param name="cell"></param>
+/// <returns>0 when the kernel is skipped.</returns>
+long long HashBroadphase::kernelWork(int cell) const
+{
+    int upperCell, rightFirst, rightLast;
+    findKernel(cell, upperCell, rightFirst, rightLast);
+    if (!isKernelAwake(cell, upperCell, rightFirst, rightLast)) return 0;
+
+    int kernelSize = cellStart[upperCell + 1] - cellStart[cell];
+    if (rightFirst >= 0) kernelSize += cellStart[rightLast + 1] - cellStart[rightFirst];
+    return (long long)(cellStart[cell + 1] - cellStart[cell]) * kernelSize;
+}
+
+/// <summary>
+/// Hands each occupied cell to the resolver with the forward half of its neighbourhood, in parallel
+/// over stripes of cell columns. Stripes of the same colour (every other stripe) never share objects;
+/// colours run one after the other with the pool's join as the barrier.
+/// </summary>
+/// <param name="objects">The objects of the last <c>update</c>, read again for current positions.</param>
+/// <param name="workers"></param>
+/// <param name="resolve"></param>
+void HashBroadphase::collide(const ParticleStore& objects, WorkerPool& workers, const BatchResolver& resolve)
+{
+    prepareBatches(workers);
+
+    const float* posX = objects.posX.data();
+    const float* posY = objects.posY.data();
+    const float* radius = objects.radius.data();
+    int threadCount = workers.getThreadCount();
+
+    for (int colour = 0; colour < 2; colour++) {
+        const std::vector<int>& stripes = colourStripes[colour];
+        int colourStripeCount = int(stripes.size());
+
+        // shared out by the work in each stripe, as in GridBroadphase::collideLevel
+        std::vector<long long>& workPrefix = stripeWork[colour];
+        workPrefix.assign(1, 0);
+        if (threadCount > 1) {
+            for (int stripe : stripes) {
+                long long work = 0;
+                for (int cell = stripeStart[stripe]; cell < stripeStart[stripe + 1]; cell++) { work += kernelWork(cell); }
+                workPrefix.push_back(workPrefix.back() + work);
+            }
+        }
+
+        workers.run([&](int thread) {
+            CandidateBatch& batch = threadBatches[thread].batch;
+            int first = 0;
+            int last = colourStripeCount;
+            if (threadCount > 1) splitByWork(workPrefix, thread, threadCount, first, last);
+
+            for (int s = first; s < last; s++) {
+                int stripe = stripes[s];
+                for (int cell = stripeStart[stripe]; cell < stripeStart[stripe + 1]; cell++) {
+                    int upperCell, rightFirst, rightLast;
+                    findKernel(cell, upperCell, rightFirst, rightLast);
+                    if (!isKernelAwake(cell, upperCell, rightFirst, rightLast)) continue;
+
+                    // consecutive cells are adjacent in cellObjects, so each part is one contiguous range
+                    batch.clear();
+                    batch.gather(cellObjects.data() + cellStart[cell], cellObjects.data() + cellStart[upperCell + 1], posX, posY, radius);
+                    if (rightFirst >= 0) {
+                        batch.gather(cellObjects.data() + cellStart[rightFirst], cellObjects.data() + cellStart[rightLast + 1], posX, posY, radius);
+                    }
+                    batch.seal();
+                    resolve(thread, batch, cellStart[cell + 1] - cellStart[cell]);
+                }
+            }
+        });
+    }
+}
+
+/// <summary>
+/// Visits every pair of objects within <c>slack</c> of touching at least once, with the half stencil
+/// of <c>collide</c> grown by as many cells as the slack carries a pair past adjacent cells.
+/// </summary>
+/// <param name="slack">Gap, in px, still counted as near.</param>
+/// <param name="visit"></param>
+void HashBroadphase::forEachNearPair(const ParticleStore&, float slack, const PairVisitor& visit)
+{
+    // centres of a near pair are at most a cell and the slack apart
+    int span = std::max(int(std::ceil((cellSize + slack) * invCellSize)), 1);
+
+    for (int cell = 0; cell < int(cellKey.size()); cell++) {
+        int col = keyCol(cellKey[cell]);
+        int row = keyRow(cellKey[cell]);
+        auto visitCell = [&](int other) {
+            if (other < 0) return;
+            for (int i = cellStart[cell]; i < cellStart[cell + 1]; i++) {
+                for (int j = cellStart[other]; j < cellStart[other + 1]; j++) { visit(cellObjects[i], cellObjects[j]); }
+            }
+        };
+
+        for (int i = cellStart[cell]; i < cellStart[cell + 1]; i++) {
+            for (int j = i + 1; j < cellStart[cell + 1]; j++) { visit(cellObjects[i], cellObjects[j]); }
+        }
+        for (int dy = 1; dy <= span; dy++) { visitCell(findCell(col, row + dy)); }
+        for (int dx = 1; dx <= span; dx++) {
+            for (int dy = -span; dy <= span; dy++) { visitCell(findCell(col + dx, row + dy)); }
+        }
+    }
+}
+
+/// <summary>
+/// Share of objects that changed cell in the last update. Objects added since the previous update
+/// count as migrated.
+/// </summary>
+/// <returns>A value between 0 and 1, or 0 before the first update.</returns>
+float HashBroadphase::getMigrationFraction() const
+{
+    return cellObjects.empty() ? 0.f : float(migratedCount) / float(cellObjects.size());
+}
+
+/// <summary>
+/// How scattered the objects are in memory relative to the cell order, measured as in
+/// <c>Grid::getDisorder</c>.
+/// </summary>
+/// <returns>0 when objects are stored in cell order, close to 1 when they are in no spatial order.</returns>
+float HashBroadphase::getDisorder() const
+{
+    if (cellObjects.size() < 2) return 0.f;
+    int scattered = 0;
+    for (size_t k = 1; k < cellObjects.size(); k++) {
+        scattered += (cellObjects[k] != cellObjects[k - 1] + 1);
+    }
+    return float(scattered) / float(cellObjects.size() - 1);
+}
+
+/// <summary>
+/// Lists every object cell by cell, in column order.
+/// </summary>
+/// <param name="order">Overwritten with a permutation of the object indices from the last update.</param>
+void HashBroadphase::getTraversalOrder(std::vector<int>& order) const { order = cellObjects; }
+
+/// <summary>
+/// Getter for the number of occupied cells.
+/// </summary>
+/// <returns>Cells holding at least one object at the last update.</returns>
+int HashBroadphase::getCellCount() const { return int(cellKey.size()); }
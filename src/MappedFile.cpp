@@ -0,0 +1,109 @@
+#include "../include/MappedFile.h"
+
+#if defined(_WIN32)
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+MappedFile::MappedFile()
+{
+    data = nullptr;
+    size = 0;
+#if defined(_WIN32)
+    fileHandle = INVALID_HANDLE_VALUE;
+    mappingHandle = nullptr;
+#else
+    descriptor = -1;
+#endif
+}
+
+MappedFile::~MappedFile() { close(); }
+
+/// <summary>
+/// Maps a file into memory, replacing any file mapped before.
+/// </summary>
+/// <param name="path"></param>
+/// <param name="prefetch">Read the whole file in now, for callers that are about to touch every page.
+/// Large files that are read piecemeal should leave the pages to be faulted in on first use.</param>
+/// <param name="error">Set to the reason when the file cannot be mapped.</param>
+/// <returns>True if <c>getData</c> now points to the file's contents. Empty files cannot be mapped.</returns>
+bool MappedFile::open(const std::string& path, bool prefetch, std::string& error)
+{
+    close();
+
+#if defined(_WIN32)
+    fileHandle = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+                             prefetch ? FILE_FLAG_SEQUENTIAL_SCAN : FILE_FLAG_RANDOM_ACCESS, nullptr);
+    LARGE_INTEGER fileSize;
+    if (fileHandle == INVALID_HANDLE_VALUE || !GetFileSizeEx(fileHandle, &fileSize)) {
+        error = "cannot open " + path;
+        close();
+        return false;
+    }
+    size = std::uint64_t(fileSize.QuadPart);
+    if (size > 0) {
+        mappingHandle = CreateFileMappingA(fileHandle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        if (mappingHandle) data = static_cast<const unsigned char*>(MapViewOfFile(mappingHandle, FILE_MAP_READ, 0, 0, 0));
+    }
+#else
+    descriptor = ::open(path.c_str(), O_RDONLY);
+    struct stat status;
+    if (descriptor < 0 || fstat(descriptor, &status) != 0) {
+        error = "cannot open " + path;
+        close();
+        return false;
+    }
+    size = std::uint64_t(status.st_size);
+    if (size > 0) {
+        int flags = MAP_PRIVATE;
+#if defined(MAP_POPULATE)
+        if (prefetch) flags |= MAP_POPULATE;
+#endif
+        void* mapped = mmap(nullptr, size_t(size), PROT_READ, flags, descriptor, 0);
+        if (mapped != MAP_FAILED) data = static_cast<const unsigned char*>(mapped);
+    }
+#endif
+
+    if (!data) {
+        error = size == 0 ? path + " is empty" : "cannot map " + path;
+        close();
+        return false;
+    }
+    return true;
+}
+
+/// <summary>
+/// Unmaps the file, if one is open.
+/// </summary>
+void MappedFile::close()
+{
+#if defined(_WIN32)
+    if (data) UnmapViewOfFile(data);
+    if (mappingHandle) CloseHandle(mappingHandle);
+    if (fileHandle != INVALID_HANDLE_VALUE) CloseHandle(fileHandle);
+    fileHandle = INVALID_HANDLE_VALUE;
+    mappingHandle = nullptr;
+#else
+    if (data) munmap(const_cast<unsigned char*>(data), size_t(size));
+    if (descriptor >= 0) ::close(descriptor);
+    descriptor = -1;
+#endif
+    data = nullptr;
+    size = 0;
+}
+
+/// <summary>
+/// Getter for the first byte of the mapped file.
+/// </summary>
+/// <returns>Null when no file is open.</returns>
+const unsigned char* MappedFile::getData() const { return data; }
+
+/// <summary>
+/// Getter for the size of the mapped file, in bytes.
+/// </summary>
+std::uint64_t MappedFile::getSize() const { return size; }
@@ -0,0 +1,155 @@
+#include "../include/NarrowPhase.h"
+
+#if defined(VV_NARROWPHASE_AVX2)
+    #include <immintrin.h>
+#elif defined(VV_NARROWPHASE_SSE2)
+    #include <emmintrin.h>
+#endif
+#if defined(_MSC_VER)
+    #include <intrin.h>
+#endif
+
+// padding lanes sit far enough away that their squared distance is finite but never an overlap
+static const float FAR_AWAY = 1.0e18f;
+
+/// <summary>
+/// Index of the lowest set bit of a non-zero mask.
+/// </summary>
+static inline int lowestBit(unsigned mask)
+{
+#if defined(_MSC_VER)
+    unsigned long bit;
+    _BitScanForward(&bit, mask);
+    return int(bit);
+#else
+    return __builtin_ctz(mask);
+#endif
+}
+
+/// <summary>
+/// Empties the batch. Capacity is kept.
+/// </summary>
+void CandidateBatch::clear() { size = 0; }
+
+/// <summary>
+/// Appends a run of objects to the batch, copying their positions and radii into consecutive lanes.
+/// </summary>
+/// <param name="first">First object index of the run, usually the start of a <c>CellSpan</c>.</param>
+/// <param name="last">One past the last object index of the run.</param>
+/// <param name="posX">The solver's x positions, indexed by object.</param>
+/// <param name="posY">The solver's y positions, indexed by object.</param>
+/// <param name="r">The solver's radii, indexed by object.</param>
+void CandidateBatch::gather(const int* first, const int* last, const float* posX, const float* posY, const float* r)
+{
+    int count = int(last - first);
+    int capacity = size + count + VV_NARROWPHASE_WIDTH;
+    if (int(x.size()) < capacity) {
+        x.resize(capacity);
+        y.resize(capacity);
+        radius.resize(capacity);
+        index.resize(capacity);
+    }
+
+    for (int k = 0; k < count; k++) {
+        int obj = first[k];
+        x[size + k] = posX[obj];
+        y[size + k] = posY[obj];
+        radius[size + k] = r[obj];
+        index[size + k] = obj;
+    }
+    size += count;
+}
+
+/// <summary>
+/// Pads the batch with one vector's worth of lanes that cannot overlap anything. Must be called
+/// after the last <c>gather</c> and before <c>NarrowPhase::nextOverlap</c>.
+/// </summary>
+void CandidateBatch::seal()
+{
+    if (int(x.size()) < size + VV_NARROWPHASE_WIDTH) {
+        x.resize(size + VV_NARROWPHASE_WIDTH);
+        y.resize(size + VV_NARROWPHASE_WIDTH);
+        radius.resize(size + VV_NARROWPHASE_WIDTH);
+        index.resize(size + VV_NARROWPHASE_WIDTH);
+    }
+    for (int lane = size; lane < size + VV_NARROWPHASE_WIDTH; lane++) {
+        x[lane] = FAR_AWAY;
+        y[lane] = FAR_AWAY;
+        radius[lane] = 0.f;
+    }
+}
+
+/// <summary>
+/// Name of the instruction set the narrow phase was built for.
+/// </summary>
+/// <returns>"AVX2", "SSE2" or "scalar"</returns>
+const char* NarrowPhase::instructionSet()
+{
+#if defined(VV_NARROWPHASE_AVX2)
+    return "AVX2";
+#elif defined(VV_NARROWPHASE_SSE2)
+    return "SSE2";
+#else
+    return "scalar";
+#endif
+}
+
+/// <summary>
+/// Tests one object against the lanes of a batch, starting at <c>first</c>, and stops at the first overlap.
+/// Uses squared distances only. Lanes at exactly the same position are not reported, matching the scalar response.
+/// </summary>
+/// <param name="batch">A sealed batch.</param>
+/// <param name="first">First lane to test.</param>
+/// <param name="px">Position of the tested object.</param>
+/// <param name="py">Position of the tested object.</param>
+/// <param name="pr">Radius of the tested object.</param>
+/// <returns>The lowest overlapping lane at or after <c>first</c>, or <c>batch.size</c> if there is none.</returns>
+int NarrowPhase::nextOverlap(const CandidateBatch& batch, int first, float px, float py, float pr)
+{
+    const float* x = batch.x.data();
+    const float* y = batch.y.data();
+    const float* r = batch.radius.data();
+    int lane = first;
+
+#if defined(VV_NARROWPHASE_AVX2)
+    const __m256 x1 = _mm256_set1_ps(px);
+    const __m256 y1 = _mm256_set1_ps(py);
+    const __m256 r1 = _mm256_set1_ps(pr);
+    const __m256 zero = _mm256_setzero_ps();
+    for (; lane < batch.size; lane += 8) {
+        __m256 dx = _mm256_sub_ps(x1, _mm256_loadu_ps(x + lane));
+        __m256 dy = _mm256_sub_ps(y1, _mm256_loadu_ps(y + lane));
+        __m256 distSq = _mm256_add_ps(_mm256_mul_ps(dx, dx), _mm256_mul_ps(dy, dy));
+        __m256 radiusSum = _mm256_add_ps(r1, _mm256_loadu_ps(r + lane));
+        __m256 hit = _mm256_and_ps(_mm256_cmp_ps(distSq, _mm256_mul_ps(radiusSum, radiusSum), _CMP_LT_OQ),
+                                   _mm256_cmp_ps(distSq, zero, _CMP_GT_OQ));
+        unsigned mask = unsigned(_mm256_movemask_ps(hit));
+        if (mask) return lane + lowestBit(mask);
+    }
+#elif defined(VV_NARROWPHASE_SSE2)
+    const __m128 x1 = _mm_set1_ps(px);
+    const __m128 y1 = _mm_set1_ps(py);
+    const __m128 r1 = _mm_set1_ps(pr);
+    const __m128 zero = _mm_setzero_ps();
+    for (; lane < batch.size; lane += 4) {
+        __m128 dx = _mm_sub_ps(x1, _mm_loadu_ps(x + lane));
+        __m128 dy = _mm_sub_ps(y1, _mm_loadu_ps(y + lane));
+        __m128 distSq = _mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy));
+        __m128 radiusSum = _mm_add_ps(r1, _mm_loadu_ps(r + lane));
+        __m128 hit = _mm_and_ps(_mm_cmplt_ps(distSq, _mm_mul_ps(radiusSum, radiusSum)),
+                                _mm_cmpgt_ps(distSq, zero));
+        unsigned mask = unsigned(_mm_movemask_ps(hit));
+        if (mask) return lane + lowestBit(mask);
+    }
+#else
+    for (; lane < batch.size; lane++) {
+        float dx = px - x[lane];
+        float dy = py - y[lane];
+        float distSq = dx * dx + dy * dy;
+        float radiusSum = pr + r[lane];
+        if (distSq < radiusSum * radiusSum && distSq > 0.f) return lane;
+    }
+#endif
+
+    return batch.size;
+}
@@ -1,7 +1,6 @@
 #include "../include/Objects.h"
+#include "../include/ParticleStore.h"
 #include <cmath>
-#include <iostream>
-
 
 /*
 ====================================================================================
@@ -15,20 +14,20 @@ CIRCLE class
 ///     position = (100, 100)
 ///     velocity = (2000, 0)
 ///     acceleration = (0, 0)
-///     mass = MAX_RADIUS
+///     mass = DEFAULT_MAX_RADIUS
 ///     coefficient of restitution = 0.95
 ///     colour = (255, 0, 0)
-///     radius = MAX_RADIUS 
+///     radius = DEFAULT_MAX_RADIUS 
 /// </summary>
 Circle::Circle() 
 {
     this->pos = Vec2D(100.0, 100.0);
     this->vel = Vec2D(2000.0, 0.0);
     this->acl = Vec2D(0.0, 0.0);
-    this->mass = float(MAX_RADIUS);
+    this->mass = float(DEFAULT_MAX_RADIUS);
     this->restitutionCoeff = 0.95f;
     this->colour = sf::Color::Red;
-    this->radius = MAX_RADIUS;
+    this->radius = DEFAULT_MAX_RADIUS;
 }
 
 /// <summary>
@@ -40,7 +39,7 @@ Circle::Circle()
 /// <param name="mass">Mass of the object. Used for calculating post-collision velocities. Must be greater than 0.</param>
 /// <param name="restitutionCoeff">Coefficient of restitution of the object. Used for calculating post-collision velocities. Must be a value between 0 and 1 inclusive.</param>
 /// <param name="colour">Object display colour.</param>
-/// <param name="radius">Object radius. Must be a value between <c>"MIN_RADIUS</c> and <c>MAX_RADIUS</c> inclusive.</param>
+/// <param name="radius">Object radius. Must be a value between 1 and <c>RADIUS_LIMIT</c> inclusive.</param>
 Circle::Circle(const Vec2D &pos, const Vec2D &vel, const Vec2D &acl, 
                 const float mass, const float restitutionCoeff, 
                 const sf::Color &colour, const int radius)
@@ -55,72 +54,18 @@ Circle::Circle(const Vec2D &pos, const Vec2D &vel, const Vec2D &acl,
 }
 
 /// <summary>
-/// Calculates an objects position and velocity in the next frame based on its current position, velocity, and acceleration.
-/// </summary>
-/// <param name="dt">The elapsed time between frames, in seconds.</param>
-void Circle::update(float dt)
-{
-    /*
-    Equations for Velocity-Verlet integration can be
-    found @ https://en.wikipedia.org/wiki/Verlet_integration
-    */
-    Vec2D halfADt, halfV, halfVDt;
-
-    // calculate v(t+0.5*dt)
-    Vec2D::scale(halfADt, acl, 0.5f * dt);
-    Vec2D::add(halfV, vel, halfADt);
-
-    // calculate new position
-    Vec2D::scale(halfVDt, halfV, dt);
-    pos.add(halfVDt);
-
-    // calculate new velocity
-    Vec2D::add(vel, halfV, halfADt);
-}
-
-/// <summary>
-/// Setter for <c>MAX_RADIUS</c>.
-/// </summary>
-/// <param name="radius">Must be a value between <c>MIN_RADIUS</c> and 300 inclusive.</param>
-void Circle::setMaxRadius(int radius)
-{
-    radius = std::min(radius, 300);
-    radius = std::max(MIN_RADIUS, radius);
-    MAX_RADIUS = radius;
-    std::cout << "Maximum object radius set to " << MAX_RADIUS << std::endl;
-}
-
-/// <summary>
-/// Setter for <c>MIN_RADIUS</c>.
-/// </summary>
-/// <param name="radius">Must be a value between 1 and <c>MAX_RADIUS</c> inclusive.</param>
-void Circle::setMinRadius(int radius)
-{
-    radius = std::max(radius, 1);
-    radius = std::min(MAX_RADIUS, radius);
-    MIN_RADIUS = radius;
-    std::cout << "Minimum object radius set to " << MIN_RADIUS << std::endl;
-}
-
-/// <summary>
-/// Getter for <c>MAX_RADIUS</c>.
-/// </summary>
-/// <returns>The maximum radius an object can have.</returns>
-int Circle::getMaxRadius() { return MAX_RADIUS; }
-/// <summary>
-/// Getter for <c>MIN_RADIUS</c>.
-/// </summary>
-/// <returns>The minimum radius an object can have.</returns>
-int Circle::getMinRadius() { return MIN_RADIUS; }
-
-/// <summary>
-/// Generates an object with with random <c>colour</c>, <c>radius</c>, and <c>mass</c>.
+/// Generates an object with random <c>colour</c>, <c>radius</c>, and <c>mass</c> drawn from the given
+/// engine. Raw engine output is used rather than a distribution, whose results differ between standard
+/// libraries, so a seed gives the same objects on every platform.
 /// </summary>
 /// <param name="circle">The output <c>Circle</c> object.</param>
-void Circle::generateRandomObject(Circle &circle)
+/// <param name="minRadius">Smallest radius to draw.</param>
+/// <param name="maxRadius">Largest radius to draw. Must be at least <c>minRadius</c>.</param>
+/// <param name="rng">The engine to draw from.</param>
+void Circle::generateRandomObject(Circle &circle, int minRadius, int maxRadius, std::mt19937 &rng)
 {
-    sf::Color randomColor = sf::Color(rand()%256, rand()%256, rand()%256);
-    int randomRadius = rand() % (MAX_RADIUS - MIN_RADIUS + 1) + MIN_RADIUS;
+    sf::Color randomColor = sf::Color(rng() % 256, rng() % 256, rng() % 256);
+    int randomRadius = int(rng() % unsigned(maxRadius - minRadius + 1)) + minRadius;
     circle.colour = randomColor;
     circle.radius = randomRadius;
     circle.mass = randomRadius;
@@ -184,37 +129,44 @@ RectBounds::RectBounds(int left, int right, int up, int down)
 /// <summary>
 /// Handles object collisions with the bounds.
 /// </summary>
-/// <param name="objects">Vector of <c>Circle</c> to apply the bounds to.</param>
-void RectBounds::applyBounds(std::vector<Circle>& objects) const {
-    for (auto& object : objects)
+/// <param name="objects">Objects to apply the bounds to.</param>
+void RectBounds::applyBounds(ParticleStore& objects) const {
+    for (int i = 0; i < objects.size(); i++)
     {
+        float& x = objects.posX[i];
+        float& y = objects.posY[i];
+        float& vx = objects.velX[i];
+        float& vy = objects.velY[i];
+        const float radius = objects.radius[i];
+        const float restitution = objects.restitution[i];
+
         // collision with right wall
-        if (object.pos.x() + object.radius > right)
+        if (x + radius > right)
         {
-            object.pos.setX(float(right - object.radius));
-            object.vel.mirrorAboutY();
-            object.vel.scale(object.restitutionCoeff);
+            x = float(right) - radius;
+            vx = -vx * restitution;
+            vy *= restitution;
         }
         // collision with left wall
-        else if (object.pos.x() - object.radius < left)
+        else if (x - radius < left)
         {
-            object.pos.setX(float(left + object.radius));
-            object.vel.mirrorAboutY();
-            object.vel.scale(object.restitutionCoeff);
+            x = float(left) + radius;
+            vx = -vx * restitution;
+            vy *= restitution;
         }
         // collision with ceiling
-        if (object.pos.y() - object.radius < up)
+        if (y - radius < up)
         {
-            object.pos.setY(float(up + object.radius));
-            object.vel.mirrorAboutX();
-            object.vel.scale(object.restitutionCoeff);
+            y = float(up) + radius;
+            vy = -vy * restitution;
+            vx *= restitution;
         }
         // collision with floor
-        else if (object.pos.y() + object.radius > down)
+        else if (y + radius > down)
         {
-            object.pos.setY(float(down - object.radius));
-            object.vel.mirrorAboutX();
-            object.vel.scale(object.restitutionCoeff);
+            y = float(down) - radius;
+            vy = -vy * restitution;
+            vx *= restitution;
         }
     }
 }
@@ -231,6 +183,7 @@ Spawner::Spawner()
     this->vel = Vec2D(2000, 0);
     this->interval = 1.f;
     this->timer = sf::Clock();
+    this->elapsed = 0.f;
     this->active = true;
     this->visible = true;
     this->colour = sf::Color::Black;
@@ -244,6 +197,7 @@ Spawner::Spawner(const std::string id, const Vec2D& pos, const Vec2D& vel,
     this->vel = vel;
     this->interval = interval;
     this->timer = sf::Clock();
+    this->elapsed = 0.f;
     this->active = active;
     this->visible = visible;
     this->colour = sf::Color::Black;
@@ -0,0 +1,157 @@
+#include "../include/ParticleStore.h"
+#include <cstring>
+
+/// <summary>
+/// Getter for the number of stored objects.
+/// </summary>
+/// <returns>The length shared by every attribute array.</returns>
+int ParticleStore::size() const { return int(posX.size()); }
+
+/// <summary>
+/// Reserves room for <c>count</c> objects in every attribute array.
+/// </summary>
+/// <param name="count"></param>
+void ParticleStore::reserve(int count)
+{
+    posX.reserve(count);
+    posY.reserve(count);
+    velX.reserve(count);
+    velY.reserve(count);
+    aclX.reserve(count);
+    aclY.reserve(count);
+    mass.reserve(count);
+    radius.reserve(count);
+    restitution.reserve(count);
+    collided.reserve(count);
+    asleep.reserve(count);
+    calmTime.reserve(count);
+    anchorX.reserve(count);
+    anchorY.reserve(count);
+    colour.reserve(count);
+    id.reserve(count);
+}
+
+/// <summary>
+/// Removes all objects and starts the ids over. Capacity is kept.
+/// </summary>
+void ParticleStore::clear()
+{
+    posX.clear();
+    posY.clear();
+    velX.clear();
+    velY.clear();
+    aclX.clear();
+    aclY.clear();
+    mass.clear();
+    radius.clear();
+    restitution.clear();
+    collided.clear();
+    asleep.clear();
+    calmTime.clear();
+    anchorX.clear();
+    anchorY.clear();
+    colour.clear();
+    id.clear();
+    nextId = 0;
+}
+
+/// <summary>
+/// Appends a <c>Circle</c>, scattering its fields into the attribute arrays.
+/// </summary>
+/// <param name="circle"></param>
+void ParticleStore::add(const Circle& circle)
+{
+    posX.push_back(circle.pos.x());
+    posY.push_back(circle.pos.y());
+    velX.push_back(circle.vel.x());
+    velY.push_back(circle.vel.y());
+    aclX.push_back(circle.acl.x());
+    aclY.push_back(circle.acl.y());
+    mass.push_back(circle.mass);
+    radius.push_back(float(circle.radius));
+    restitution.push_back(circle.restitutionCoeff);
+    collided.push_back(0);
+    asleep.push_back(0);
+    calmTime.push_back(0.f);
+    anchorX.push_back(circle.pos.x());
+    anchorY.push_back(circle.pos.y());
+    colour.push_back(circle.colour);
+    id.push_back(nextId++);
+}
+
+/// <summary>
+/// Rearranges one attribute array so that element <c>i</c> becomes the old element <c>order[i]</c>.
+/// </summary>
+template <typename Vector>
+static void applyOrder(Vector& values, const std::vector<int>& order)
+{
+    Vector reordered(values.size());
+    for (size_t i = 0; i < order.size(); i++) { reordered[i] = values[order[i]]; }
+    values.swap(reordered);
+}
+
+/// <summary>
+/// Reorders every object. Object indices held anywhere else are invalidated.
+/// </summary>
+/// <param name="order">A permutation of 0 to <c>size() - 1</c>; object <c>i</c> becomes the old object <c>order[i]</c>.</param>
+void ParticleStore::permute(const std::vector<int>& order)
+{
+    applyOrder(posX, order);
+    applyOrder(posY, order);
+    applyOrder(velX, order);
+    applyOrder(velY, order);
+    applyOrder(aclX, order);
+    applyOrder(aclY, order);
+    applyOrder(mass, order);
+    applyOrder(radius, order);
+    applyOrder(restitution, order);
+    applyOrder(collided, order);
+    applyOrder(asleep, order);
+    applyOrder(calmTime, order);
+    applyOrder(anchorX, order);
+    applyOrder(anchorY, order);
+    applyOrder(colour, order);
+    applyOrder(id, order);
+}
+
+/// <summary>
+/// Gathers one object back into a <c>Circle</c>. Intended for debugging and inspection, not for per-frame use.
+/// </summary>
+/// <param name="idx">Must be a value between 0 and <c>size() - 1</c> inclusive.</param>
+/// <returns>A copy of the object at <c>idx</c>.</returns>
+Circle ParticleStore::get(int idx) const
+{
+    return Circle(Vec2D(posX[idx], posY[idx]),
+                  Vec2D(velX[idx], velY[idx]),
+                  Vec2D(aclX[idx], aclY[idx]),
+                  mass[idx], restitution[idx], colour[idx], int(radius[idx]));
+}
+
+/// <summary>
+/// Fingerprint of the simulated state: the position, velocity and sleep flag of every object, bit for
+/// bit. Each object is hashed on its own and the results are summed, so the value does not depend on
+/// the order objects are stored in and survives reorders.
+/// </summary>
+/// <returns>Equal for two stores only if, barring collisions, they hold the same objects in the same state.</returns>
+std::uint64_t ParticleStore::hash() const
+{
+    auto bits = [](float value) {
+        std::uint32_t word;
+        std::memcpy(&word, &value, sizeof word);
+        return std::uint64_t(word);
+    };
+    // splitmix64 finaliser, every input bit affects every output bit
+    auto mix = [](std::uint64_t h) {
+        h ^= h >> 30; h *= 0xbf58476d1ce4e5b9ull;
+        h ^= h >> 27; h *= 0x94d049bb133111ebull;
+        return h ^ (h >> 31);
+    };
+
+    std::uint64_t total = mix(std::uint64_t(size()));
+    for (int i = 0; i < size(); i++) {
+        std::uint64_t h = mix((bits(posX[i]) << 32) | bits(posY[i]));
+        h = mix(h ^ ((bits(velX[i]) << 32) | bits(velY[i])));
+        total += mix(h ^ asleep[i]);
+    }
+    return total;
+}
@@ -0,0 +1,122 @@
+#include "../include/Profiler.h"
+#include <algorithm>
+#include <cmath>
+
+/// <summary>
+/// Constructs a profiler with an empty rolling window.
+/// </summary>
+Profiler::Profiler()
+{
+    sortScratch.reserve(PROFILE_WINDOW);
+    setWorkerCount(1);
+}
+
+/// <summary>
+/// Sizes the per-worker columns and starts a fresh rolling window. Called from the solver thread only.
+/// </summary>
+/// <param name="workerCount">Number of workers in the solver's pool.</param>
+void Profiler::setWorkerCount(int workerCount)
+{
+    currentBusy.assign(std::max(workerCount, 1), 0);
+    history.assign(PROFILE_WINDOW * (PROFILE_PHASE_COUNT + 1 + currentBusy.size()), 0);
+    std::fill(current, current + PROFILE_PHASE_COUNT, 0);
+    frameCount = 0;
+    head = 0;
+    filled = 0;
+}
+
+/// <summary>
+/// Adds time to a phase of the frame in progress. Called from the solver thread only.
+/// </summary>
+/// <param name="phase"></param>
+/// <param name="ns">Elapsed time, in nanoseconds.</param>
+void Profiler::add(ProfilePhase phase, long long ns) { current[int(phase)] += ns; }
+
+/// <summary>
+/// Adds time one worker spent on collision jobs to the frame in progress. Called from the solver
+/// thread only, after the jobs have joined.
+/// </summary>
+/// <param name="worker"></param>
+/// <param name="ns">Busy time, in nanoseconds.</param>
+void Profiler::addCollisionBusy(int worker, long long ns) { currentBusy[worker] += ns; }
+
+/// <summary>
+/// Closes the frame in progress, pushes it into the rolling window, and publishes fresh
+/// <c>FrameStats</c> for readers. Called from the solver thread only.
+/// </summary>
+/// <param name="frameNs">Duration of the whole frame, in nanoseconds.</param>
+void Profiler::endFrame(long long frameNs)
+{
+    const int workerCount = int(currentBusy.size());
+    const int columns = PROFILE_PHASE_COUNT + 1 + workerCount;
+    long long* row = &history[head * columns];
+    std::copy(current, current + PROFILE_PHASE_COUNT, row);
+    row[PROFILE_PHASE_COUNT] = frameNs;
+    std::copy(currentBusy.begin(), currentBusy.end(), row + PROFILE_PHASE_COUNT + 1);
+    std::fill(current, current + PROFILE_PHASE_COUNT, 0);
+    std::fill(currentBusy.begin(), currentBusy.end(), 0);
+
+    int latestRow = head;
+    head = (head + 1) % PROFILE_WINDOW;
+    filled = std::min(filled + 1, PROFILE_WINDOW);
+    frameCount++;
+
+    FrameStats& stats = published.writeSlot();
+    stats.frameCount = frameCount;
+    stats.window = filled;
+    stats.collisionBusy.resize(workerCount);
+
+    for (int column = 0; column < columns; column++) {
+        sortScratch.clear();
+        double sum = 0.0;
+        for (int r = 0; r < filled; r++) {
+            double ms = history[r * columns + column] * 1e-6;
+            sortScratch.push_back(ms);
+            sum += ms;
+        }
+
+        PhaseStats& phase = (column < PROFILE_PHASE_COUNT) ? stats.phases[column]
+                          : (column == PROFILE_PHASE_COUNT) ? stats.frame
+                          : stats.collisionBusy[column - PROFILE_PHASE_COUNT - 1];
+        phase.lastMs = history[latestRow * columns + column] * 1e-6;
+        phase.minMs = *std::min_element(sortScratch.begin(), sortScratch.end());
+        phase.maxMs = *std::max_element(sortScratch.begin(), sortScratch.end());
+        phase.meanMs = sum / filled;
+
+        // nearest-rank 99th percentile
+        int rank = std::max(1, int(std::ceil(0.99 * filled))) - 1;
+        std::nth_element(sortScratch.begin(), sortScratch.begin() + rank, sortScratch.end());
+        phase.p99Ms = sortScratch[rank];
+    }
+
+    published.publish();
+}
+
+/// <summary>
+/// Reads the most recently published stats without blocking the solver. Only one thread may read.
+/// </summary>
+/// <returns>A copy of the latest stats, or zeroed stats if no frame has been recorded.</returns>
+FrameStats Profiler::latest()
+{
+    published.update();
+    return published.readSlot();
+}
+
+/// <summary>
+/// Display name of a phase.
+/// </summary>
+const char* Profiler::phaseName(ProfilePhase phase)
+{
+    switch (phase) {
+    case ProfilePhase::Gravity:     return "gravity";
+    case ProfilePhase::Bounds:      return "bounds";
+    case ProfilePhase::Partition:   return "partition";
+    case ProfilePhase::Collision:   return "collision";
+    case ProfilePhase::Restitution: return "restitution";
+    case ProfilePhase::Integrate:   return "integrate";
+    case ProfilePhase::Sleep:       return "sleep";
+    case ProfilePhase::Spawn:       return "spawn";
+    case ProfilePhase::Record:      return "record";
+    default:                        return "unknown";
+    }
+}
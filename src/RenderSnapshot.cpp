@@ -0,0 +1,43 @@
+#include "../include/RenderSnapshot.h"
+#include "../include/ParticleStore.h"
+#include <algorithm>
+
+/// <summary>
+/// Getter for the number of objects in the snapshot.
+/// </summary>
+int RenderSnapshot::size() const { return int(posX.size()); }
+
+/// <summary>
+/// Overwrites the snapshot with the current state of <c>objects</c>.
+/// </summary>
+/// <param name="objects"></param>
+/// <param name="startX">Positions at the start of the frame. Objects added during the frame have none and start where they are.</param>
+/// <param name="startY"></param>
+/// <param name="bounds"></param>
+/// <param name="frameNumber"></param>
+void RenderSnapshot::capture(const ParticleStore& objects, const AlignedVector<float>& startX, const AlignedVector<float>& startY,
+                             const RectBounds& bounds, long long frameNumber)
+{
+    int count = objects.size();
+    posX.resize(count);
+    posY.resize(count);
+    previousX.resize(count);
+    previousY.resize(count);
+    radius.resize(count);
+    colour.resize(count);
+
+    std::copy(objects.posX.begin(), objects.posX.end(), posX.begin());
+    std::copy(objects.posY.begin(), objects.posY.end(), posY.begin());
+
+    int carried = std::min(count, int(startX.size()));
+    std::copy(startX.begin(), startX.begin() + carried, previousX.begin());
+    std::copy(startY.begin(), startY.begin() + carried, previousY.begin());
+    std::copy(objects.posX.begin() + carried, objects.posX.end(), previousX.begin() + carried);
+    std::copy(objects.posY.begin() + carried, objects.posY.end(), previousY.begin() + carried);
+
+    std::copy(objects.radius.begin(), objects.radius.end(), radius.begin());
+    std::copy(objects.colour.begin(), objects.colour.end(), colour.begin());
+
+    this->bounds = bounds;
+    frame = frameNumber;
+}
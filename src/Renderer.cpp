@@ -1,11 +1,46 @@
 #include "../include/Renderer.h"
 #include <cmath>
+#include <algorithm>
+#include <thread>
+#include <vector>
 #include <SFML/System/Vector2.hpp>
 
-Renderer::Renderer() {
+Renderer::Renderer() : objectVertices(sf::Triangles), workers(int(std::min(4u, std::max(1u, std::thread::hardware_concurrency())))) {
     bgColour = sf::Color::White;
     ballColour = sf::Color::Red;
     randomBallColour = true;
+    circleTextureReady = false;
+}
+
+/// <summary>
+/// Rasterises a white disc with a one pixel anti-aliased edge into <c>circleTexture</c>. Every object
+/// is drawn as a quad textured with it; vertex colours tint it to the object's colour. Must be called
+/// on the thread that owns the window's context.
+/// </summary>
+void Renderer::createCircleTexture()
+{
+    const int size = CIRCLE_TEXTURE_SIZE;
+    const float centre = size / 2.f;
+    const float radius = size / 2.f - 1.f;
+    std::vector<sf::Uint8> pixels(size * size * 4);
+
+    for (int y = 0; y < size; y++) {
+        for (int x = 0; x < size; x++) {
+            float dx = x + 0.5f - centre;
+            float dy = y + 0.5f - centre;
+            // coverage falls from 1 to 0 across the pixel straddling the edge
+            float coverage = std::clamp(radius - std::sqrt(dx * dx + dy * dy) + 0.5f, 0.f, 1.f);
+            sf::Uint8* pixel = &pixels[(y * size + x) * 4];
+            pixel[0] = pixel[1] = pixel[2] = 255;
+            pixel[3] = sf::Uint8(std::lround(coverage * 255.f));
+        }
+    }
+
+    circleTexture.create(size, size);
+    circleTexture.update(pixels.data());
+    circleTexture.setSmooth(true);
+    circleTexture.generateMipmap();     // keeps small circles smooth when the texture is minified
+    circleTextureReady = true;
 }
 
 /// <summary>
@@ -13,34 +48,68 @@ Renderer::Renderer() {
 /// </summary>
 /// <param name="solver"></param>
 /// <param name="window"></param>
-void Renderer::renderSolver(Solver &solver, sf::RenderWindow &window)
+/// <param name="alpha">How far between the snapshot's previous and current positions to draw, from 0 to 1.</param>
+void Renderer::renderSolver(Solver &solver, sf::RenderWindow &window, float alpha)
+{
+    // take the latest frame the solver finished; never touches the live object arrays
+    renderSnapshot(solver.getRenderSnapshot(), window, alpha);
+}
+
+/// <summary>
+/// Draws all objects of a <c>snapshot</c> to a <c>window</c>, whether a solver or a trajectory player filled it.
+/// </summary>
+/// <param name="snapshot"></param>
+/// <param name="window"></param>
+/// <param name="alpha">How far between the snapshot's previous and current positions to draw, from 0 to 1.</param>
+void Renderer::renderSnapshot(const RenderSnapshot &snapshot, sf::RenderWindow &window, float alpha)
 {
     // render bounding box=====================================================
-    RectBounds* bounds = solver.getBounds();
-    sf::RectangleShape boundingBox = sf::RectangleShape(sf::Vector2f(float(bounds->right - bounds->left), float(bounds->down - bounds->up)));
+    const RectBounds& bounds = snapshot.bounds;
+    sf::RectangleShape boundingBox = sf::RectangleShape(sf::Vector2f(float(bounds.right - bounds.left), float(bounds.down - bounds.up)));
     boundingBox.setFillColor(bgColour);
     window.draw(boundingBox);
 
     // render objects==========================================================
-    std::vector<Circle> objects = solver.getObjects();
-    float vectorScale = 0.02f;
-    int lineWidth = 3;
-    sf::Color colour;
-
-    for (auto &obj : objects)
-    {
-        if (randomBallColour) colour = obj.colour;
-        else colour = ballColour;
-
-        // circle point count is currently 30 but i intend to reduce it to 20 when testing is complete
-        sf::CircleShape ball = sf::CircleShape(float(obj.radius));
-        ball.setOrigin(float(obj.radius), float(obj.radius));
-        ball.setFillColor(colour);
-        ball.setPosition(obj.pos.x(), obj.pos.y());
-        window.draw(ball);
-
-        // render velocity vectors
-    }
+    if (!circleTextureReady) createCircleTexture();
+
+    int objectCount = snapshot.size();
+    objectVertices.resize(size_t(objectCount) * VERTICES_PER_OBJECT);
+
+    const float texSize = float(CIRCLE_TEXTURE_SIZE);
+    alpha = std::clamp(alpha, 0.f, 1.f);
+    const bool useObjectColour = randomBallColour;
+    const sf::Color fixedColour = ballColour;
+
+    // each worker writes the quads of one contiguous chunk of objects
+    workers.run([&](int thread) {
+        int threadCount = workers.getThreadCount();
+        int first = int((long long)objectCount * thread / threadCount);
+        int last = int((long long)objectCount * (thread + 1) / threadCount);
+
+        for (int i = first; i < last; i++) {
+            float x = snapshot.previousX[i] + (snapshot.posX[i] - snapshot.previousX[i]) * alpha;
+            float y = snapshot.previousY[i] + (snapshot.posY[i] - snapshot.previousY[i]) * alpha;
+            float r = snapshot.radius[i];
+            sf::Color colour = useObjectColour ? snapshot.colour[i] : fixedColour;
+
+            sf::Vertex topLeft(sf::Vector2f(x - r, y - r), colour, sf::Vector2f(0.f, 0.f));
+            sf::Vertex topRight(sf::Vector2f(x + r, y - r), colour, sf::Vector2f(texSize, 0.f));
+            sf::Vertex bottomRight(sf::Vector2f(x + r, y + r), colour, sf::Vector2f(texSize, texSize));
+            sf::Vertex bottomLeft(sf::Vector2f(x - r, y + r), colour, sf::Vector2f(0.f, texSize));
+
+            sf::Vertex* quad = &objectVertices[size_t(i) * VERTICES_PER_OBJECT];
+            quad[0] = topLeft;
+            quad[1] = topRight;
+            quad[2] = bottomRight;
+            quad[3] = topLeft;
+            quad[4] = bottomRight;
+            quad[5] = bottomLeft;
+        }
+    });
+
+    window.draw(objectVertices, sf::RenderStates(&circleTexture));
+
+    // render velocity vectors
 
 
     // render spawners=========================================================
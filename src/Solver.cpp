@@ -2,25 +2,67 @@
 #include <iostream>
 #include <thread>
 #include <cmath>
+#include <algorithm>
+#include <chrono>
+#include <sstream>
 
-#include <QtWidgets/qmessagebox.h>
+/// <summary>
+/// Constructs a solver with one collision worker per hardware thread.
+/// </summary>
+Solver::Solver() : Solver(int(std::thread::hardware_concurrency())) {}
 
-Solver::Solver()
+/// <summary>
+/// Constructs a solver with the given number of collision workers.
+/// </summary>
+/// <param name="threadCount">Size of the worker pool used by <c>applyCollisions</c>, including the solver thread. Clamped to at least 1.</param>
+Solver::Solver(int threadCount) : workers(threadCount)
 {
+    collisionScratch.resize(workers.getThreadCount());
+    profiler.setWorkerCount(workers.getThreadCount());
+    pairTestCount = 0;
+    frameCount = 0;
+    restartPending = false;
+    wakePending = false;
+    requestedBroadphase = BroadphaseKind::Grid;
+    seedPending = false;
+    reservePending = 0;
+    stateHash = 0;
+    activeBroadphase = BroadphaseKind::Grid;
+    broadphase = &gridBroadphase;
+    asleepCount = 0;
+    migrationFraction = 0.f;
+    framesSinceReorder = 0;
+    reorderCount = 0;
     objects.clear();
     GRAVITY = Vec2D(0.f, 3000.f);
     BOUNDS = RectBounds();
-    grid = Grid(Circle::getMaxRadius(), BOUNDS.right, BOUNDS.down);
+    gridBroadphase.getGrids().setGridSize(BOUNDS.right, BOUNDS.down);
     FRAMERATE = 60;
     SUBSTEPS = 4;
+    MIN_SUBSTEPS = 1;
+    ADAPTIVE_SUBSTEPS = false;
+    CFL_LIMIT = 0.5f;
+    frameSubsteps = SUBSTEPS;
+    DETERMINISTIC = false;
+    SEED = 1;
+    rng.seed(SEED);
+    JACOBI_CONTACTS = false;
+    SLEEPING = false;
+    SLEEP_DRIFT = 5.f;
+    SLEEP_TIME = 0.5f;
+    WAKE_SPEED = 400.f;
+    REORDER_INTERVAL = 0;
+    REORDER_DISORDER = 0.9f;
     MAX_OBJECTS = 300;
+    MIN_RADIUS = Circle::DEFAULT_MIN_RADIUS;
+    MAX_RADIUS = Circle::DEFAULT_MAX_RADIUS;
     SPAWN_INTERVAL = 1.f;
     paused = false;
     autoSpawning = true;
 }
 
-void Solver::setGravity(const Vec2D& gravity) { GRAVITY = gravity; }
-void Solver::setBounds(const RectBounds& bounds) { BOUNDS = bounds; }
+void Solver::setGravity(const Vec2D& gravity) { GRAVITY = gravity; wakeAll(); }
+void Solver::setBounds(const RectBounds& bounds) { BOUNDS = bounds; wakeAll(); }
 
 void Solver::setSpawnInterval(float interval)
 {
@@ -28,141 +70,488 @@ void Solver::setSpawnInterval(float interval)
     SPAWN_INTERVAL = interval;
 }
 
+/// <summary>
+/// Selects the broadphase used by the collision pass from the start of the next frame. Safe to call from the UI thread.
+/// </summary>
+/// <param name="kind"></param>
+void Solver::setBroadphase(BroadphaseKind kind)
+{
+    if (kind == BroadphaseKind::Count) return;
+    requestedBroadphase = kind;
+}
+
 Vec2D Solver::getGravity() const            { return GRAVITY; }
 RectBounds* Solver::getBounds()             { return &BOUNDS; }
-Grid* Solver::getGrid()                     { return &grid; }
+GridHierarchy* Solver::getGrid()            { return &gridBroadphase.getGrids(); }
+TrajectoryRecorder* Solver::getRecorder()   { return &recorder; }
+BroadphaseKind Solver::getBroadphase() const { return activeBroadphase; }
+const char* Solver::getBroadphaseName() const { return broadphase->getName(); }
 int Solver::getFramerate() const            { return FRAMERATE; }
 int Solver::getSubsteps() const             { return SUBSTEPS; }
+int Solver::getMinSubsteps() const          { return MIN_SUBSTEPS; }
+bool Solver::getAdaptiveSubsteps() const    { return ADAPTIVE_SUBSTEPS; }
+int Solver::getFrameSubsteps() const        { return frameSubsteps; }
+bool Solver::getJacobiContacts() const      { return JACOBI_CONTACTS; }
+bool Solver::getDeterministic() const       { return DETERMINISTIC; }
+unsigned Solver::getSeed() const            { return SEED; }
+
+/// <summary>
+/// Fingerprint of the objects after the last frame, see <c>ParticleStore::hash</c>. Two runs with
+/// the same seed, parameters and inputs give the same value frame for frame, at any thread count.
+/// </summary>
+/// <returns>0 unless <c>DETERMINISTIC</c> was set for the last frame.</returns>
+std::uint64_t Solver::getStateHash() const  { return stateHash; }
+bool Solver::getSleeping() const            { return SLEEPING; }
+int Solver::getAwakeCount() const           { return int(objects.size()) - asleepCount; }
+int Solver::getAsleepCount() const          { return asleepCount; }
+float Solver::getMigrationFraction() const  { return migrationFraction; }
+int Solver::getReorderCount() const         { return reorderCount; }
+int Solver::getThreadCount() const          { return workers.getThreadCount(); }
+long long Solver::getPairTestCount() const  { return pairTestCount; }
+
+/// <summary>
+/// Per-phase timings over the last <c>PROFILE_WINDOW</c> frames. Safe to call from one thread
+/// other than the solver thread; it never blocks the simulation.
+/// </summary>
+FrameStats Solver::getFrameStats()         { return profiler.latest(); }
 int Solver::getMaxObjects() const           { return MAX_OBJECTS; }
+int Solver::getMinRadius() const            { return MIN_RADIUS; }
+int Solver::getMaxRadius() const            { return MAX_RADIUS; }
 float Solver::getSpawnInterval() const      { return SPAWN_INTERVAL; }
 int Solver::getObjectCount() const          { return int(objects.size()); }
-const std::vector<Circle>& Solver::getObjects() const { return objects; }
+const ParticleStore& Solver::getObjects() const { return objects; }
+
+/// <summary>
+/// Takes the most recently published snapshot. Only the render thread may call this; the
+/// reference stays valid until its next call and is never written to by the solver.
+/// </summary>
+const RenderSnapshot& Solver::getRenderSnapshot()
+{
+    renderSnapshots.update();
+    return renderSnapshots.readSlot();
+}
 
 /// <summary>
 /// Sets object acceleration value to that of <c>GRAVITY</c>.
 /// </summary>
 void Solver::applyGravity()
 {
-    for (auto &object : objects)
+    VV_PROFILE_PHASE(profiler, ProfilePhase::Gravity);
+    std::fill(objects.aclX.begin(), objects.aclX.end(), GRAVITY.x());
+    std::fill(objects.aclY.begin(), objects.aclY.end(), GRAVITY.y());
+}
+
+/// <summary>
+/// Brings the active broadphase up to date and resolves every batch of candidates it finds, either
+/// contact by contact as they are found or, with <c>JACOBI_CONTACTS</c>, in three passes through
+/// <c>countBatch</c>, <c>gatherBatch</c> and <c>applyContacts</c>.
+/// </summary>
+void Solver::applyCollisions()
+{
     {
-        object.acl.setX(GRAVITY.x());
-        object.acl.setY(GRAVITY.y());
+        VV_PROFILE_PHASE(profiler, ProfilePhase::Partition);
+        broadphase->update(objects);
+    }
+    VV_PROFILE_PHASE(profiler, ProfilePhase::Collision);
+
+    for (auto& scratch : collisionScratch) { scratch.pairTests = 0; }
+    workers.resetBusyTimes();
+
+    if (JACOBI_CONTACTS) {
+        int objectCount = objects.size();
+        contactShiftX.assign(objectCount, 0.f);
+        contactShiftY.assign(objectCount, 0.f);
+        contactImpulseX.assign(objectCount, 0.f);
+        contactImpulseY.assign(objectCount, 0.f);
+        contactCount.assign(objectCount, 0);
+        contactWake.assign(objectCount, 0);
+
+        // every contact's share depends on the contact counts of both its objects, so they are counted first
+        broadphase->collide(objects, workers, [this](int, CandidateBatch& batch, int owners) {
+            countBatch(batch, owners);
+        });
+        broadphase->collide(objects, workers, [this](int thread, CandidateBatch& batch, int owners) {
+            gatherBatch(batch, owners, collisionScratch[thread]);
+        });
+        applyContacts();
     }
+    else {
+        broadphase->collide(objects, workers, [this](int thread, CandidateBatch& batch, int owners) {
+            resolveBatch(batch, owners, collisionScratch[thread]);
+        });
+    }
+
+    pairTestCount = 0;
+    for (auto& scratch : collisionScratch) { pairTestCount += scratch.pairTests; }
+
+#if VV_PROFILING
+    // how evenly the broadphase spread the work, see FrameStats::collisionBusy
+    for (int thread = 0; thread < workers.getThreadCount(); thread++) {
+        profiler.addCollisionBusy(thread, workers.getBusyTime(thread));
+    }
+#endif
 }
 
 /// <summary>
-/// Partitions objects into grid cells and creates threads to perform collision detection on the objects.
+/// Tests each of the first <c>owners</c> lanes of a batch against every lane after it and resolves
+/// the overlaps found, keeping the lanes of moved objects current for the remaining tests.
 /// </summary>
-void Solver::applyCollisions()
+/// <param name="batch">A sealed batch from the broadphase.</param>
+/// <param name="owners">Number of leading lanes to test.</param>
+/// <param name="scratch">The calling worker's scratch space.</param>
+void Solver::resolveBatch(CandidateBatch& batch, int owners, CollisionScratch& scratch)
+{
+    const float* posX = objects.posX.data();
+    const float* posY = objects.posY.data();
+    long long pairTests = 0;
+
+    for (int i = 0; i < owners; i++) {
+        int obj1 = batch.index[i];
+        int lane = NarrowPhase::nextOverlap(batch, i + 1, batch.x[i], batch.y[i], batch.radius[i]);
+        while (lane < batch.size) {
+            int obj2 = batch.index[lane];
+            resolveCollision(obj1, obj2);
+
+            // both objects moved, keep their lanes current for the remaining tests
+            batch.x[i] = posX[obj1]; batch.y[i] = posY[obj1];
+            batch.x[lane] = posX[obj2]; batch.y[lane] = posY[obj2];
+            lane = NarrowPhase::nextOverlap(batch, lane + 1, batch.x[i], batch.y[i], batch.radius[i]);
+        }
+        pairTests += batch.size - i - 1;
+    }
+
+    scratch.pairTests += pairTests;
+}
+
+/// <summary>
+/// Tests two objects for overlap and, if they overlap, applies an elastic collision response and separates them.
+/// </summary>
+/// <param name="obj1">Index of the first object.</param>
+/// <param name="obj2">Index of the second object.</param>
+void Solver::resolveCollision(int obj1, int obj2)
 {
-    grid.partitionObjects(objects);
+    float* posX = objects.posX.data();
+    float* posY = objects.posY.data();
+    float* velX = objects.velX.data();
+    float* velY = objects.velY.data();
+    const float* mass = objects.mass.data();
+    const float* radius = objects.radius.data();
+    std::uint8_t* asleep = objects.asleep.data();
+
+    // sleeping objects never move each other
+    if (asleep[obj1] && asleep[obj2]) return;
+
+    float dx = posX[obj1] - posX[obj2];
+    float dy = posY[obj1] - posY[obj2];
+    float distSq = dx * dx + dy * dy;
+    float radiusSum = radius[obj1] + radius[obj2];
+
+    // no overlap, therefore no collision, so skip
+    if (distSq >= radiusSum * radiusSum || distSq == 0.f) return;
+
+    /*
+    A sleeping object is static to slow movers, so a pile can hold up
+    objects resting on it without waking. A fast enough impact wakes
+    it and the collision is resolved as usual.
+    */
+    if (asleep[obj1] || asleep[obj2]) {
+        int sleeper = asleep[obj1] ? obj1 : obj2;
+        int mover = asleep[obj1] ? obj2 : obj1;
+        float speedSq = velX[mover] * velX[mover] + velY[mover] * velY[mover];
+
+        if (speedSq < WAKE_SPEED * WAKE_SPEED) {
+            float sign = (mover == obj1) ? 1.f : -1.f;
+            resolveStaticCollision(mover, sign * dx, sign * dy, distSq, radiusSum);
+            return;
+        }
+        asleep[sleeper] = 0;
+        objects.calmTime[sleeper] = 0.f;
+    }
+
+    /*
+    Calculate new velocities using equations for two-dimensional
+    collision with two moving objects
+
+    Equations in vector representation can be
+    found @ https://en.wikipedia.org/wiki/Elastic_collision
+
+    Both objects share the same dot product and collision axis,
+    so v1 and v2 are updated from the same scalar term
+    */
+    float invDist = 1.f / std::sqrt(distSq);
+    float dot12 = (velX[obj1] - velX[obj2]) * dx + (velY[obj1] - velY[obj2]) * dy;
+    float impulse = 2.0f * dot12 * invDist * invDist / (mass[obj1] + mass[obj2]);
+    float scalar1 = mass[obj2] * impulse;
+    float scalar2 = mass[obj1] * impulse;
+
+    velX[obj1] -= scalar1 * dx;
+    velY[obj1] -= scalar1 * dy;
+    velX[obj2] += scalar2 * dx;
+    velY[obj2] += scalar2 * dy;
+
+    /*
+    Update positions by shifting each object by half the overlap
+    in opposite directions along the collision axis
+    */
+    float shift = 0.5f * (radiusSum * invDist - 1.f);
+    posX[obj1] += dx * shift;
+    posY[obj1] += dy * shift;
+    posX[obj2] -= dx * shift;
+    posY[obj2] -= dy * shift;
+
+    //Set collision status for velocity scaling later
+    objects.collided[obj1] = 1; objects.collided[obj2] = 1;
+}
 
-    // should be solver attributes
-    int threadCount = 4;
-    int cellsPerThread = int(grid.WIDTH / threadCount) * grid.HEIGHT;
-    int finalThreadCellCount = grid.WIDTH - (threadCount * cellsPerThread);
+/// <summary>
+/// Bounces a moving object off a sleeping one as if the sleeper had infinite mass. Only the mover is written.
+/// </summary>
+/// <param name="mover">Index of the awake object.</param>
+/// <param name="dx">x component of mover minus sleeper.</param>
+/// <param name="dy">y component of mover minus sleeper.</param>
+/// <param name="distSq">Squared distance between the centres, non-zero.</param>
+/// <param name="radiusSum">Sum of both radii.</param>
+void Solver::resolveStaticCollision(int mover, float dx, float dy, float distSq, float radiusSum)
+{
+    float invDist = 1.f / std::sqrt(distSq);
 
-    // create threads 
-    std::vector<std::thread*> threadPool;
-    for (int thread = 0; thread < threadCount; thread++) {
-        int startCellIdx = thread * cellsPerThread;
-        int endCellIdx = (thread == threadCount - 1) ? int(grid.cells.size()) : startCellIdx + cellsPerThread;
-        std::thread* th_collision = new std::thread(&Solver::collisionDetectionThread, this, startCellIdx, endCellIdx);
-        threadPool.push_back(th_collision);
+    // reflect the part of the velocity heading into the sleeper
+    float approach = (objects.velX[mover] * dx + objects.velY[mover] * dy) * invDist * invDist;
+    if (approach < 0.f) {
+        objects.velX[mover] -= 2.f * approach * dx;
+        objects.velY[mover] -= 2.f * approach * dy;
     }
 
-    // wait for all threads to finish
-    for (auto th_collision : threadPool) { th_collision->join(); delete th_collision; }
+    // the mover takes the whole overlap
+    float shift = radiusSum * invDist - 1.f;
+    objects.posX[mover] += dx * shift;
+    objects.posY[mover] += dy * shift;
+
+    objects.collided[mover] = 1;
+}
 
-    grid.resetCells();
+/// <summary>
+/// Tests each of the first <c>owners</c> lanes of a batch against every lane after it and counts the
+/// contacts found, for <c>gatherContact</c> to share each object's response among them. The tests are
+/// the gather pass's again, so they are not added to the pair test count.
+/// </summary>
+/// <param name="batch">A sealed batch from the broadphase.</param>
+/// <param name="owners">Number of leading lanes to test.</param>
+void Solver::countBatch(CandidateBatch& batch, int owners)
+{
+    for (int i = 0; i < owners; i++) {
+        int obj1 = batch.index[i];
+        int lane = NarrowPhase::nextOverlap(batch, i + 1, batch.x[i], batch.y[i], batch.radius[i]);
+        while (lane < batch.size) {
+            countContact(obj1, batch.index[lane]);
+            lane = NarrowPhase::nextOverlap(batch, lane + 1, batch.x[i], batch.y[i], batch.radius[i]);
+        }
+    }
 }
 
 /// <summary>
-/// The thread function that performs collision detection.
+/// Counts a contact against each object <c>gatherContact</c> will give a response to, making exactly
+/// the same decisions.
 /// </summary>
-/// <param name="startCellIdx">Always in the bottom row of cells by design.</param>
-/// <param name="endCellIdx">Always in the top row of cells by design.</param>
-void Solver::collisionDetectionThread(int startCellIdx, int endCellIdx) {
+/// <param name="obj1">Index of the first object.</param>
+/// <param name="obj2">Index of the second object.</param>
+void Solver::countContact(int obj1, int obj2)
+{
+    const float* posX = objects.posX.data();
+    const float* posY = objects.posY.data();
+    const float* velX = objects.velX.data();
+    const float* velY = objects.velY.data();
+    const float* radius = objects.radius.data();
+    const std::uint8_t* asleep = objects.asleep.data();
+
+    if (asleep[obj1] && asleep[obj2]) return;
+
+    float dx = posX[obj1] - posX[obj2];
+    float dy = posY[obj1] - posY[obj2];
+    float distSq = dx * dx + dy * dy;
+    float radiusSum = radius[obj1] + radius[obj2];
 
-    for (int cellIdx = startCellIdx; cellIdx < endCellIdx; cellIdx++) {
-        if (grid.isLeftCol(cellIdx) || grid.isRightCol(cellIdx) ||
-            grid.isTopRow(cellIdx) || grid.isBottomRow(cellIdx)) continue;
+    if (distSq >= radiusSum * radiusSum || distSq == 0.f) return;
 
-        // create list of obj in current and adjacent cells
-        int kernelCells[9] = { cellIdx - grid.HEIGHT - 1, cellIdx - grid.HEIGHT, cellIdx - grid.HEIGHT + 1,
-                               cellIdx - 1,               cellIdx,               cellIdx + 1,
-                               cellIdx + grid.HEIGHT - 1, cellIdx + grid.HEIGHT, cellIdx + grid.HEIGHT + 1 };
-        std::vector<Circle*> kernelObjs;
-        for (int kCellIdx : kernelCells) {
-            for (Circle* obj : grid.cells.at(kCellIdx)) { kernelObjs.push_back(obj); }
+    // a slow mover bounces off a sleeper, which takes no part in the contact
+    if (asleep[obj1] || asleep[obj2]) {
+        int mover = asleep[obj1] ? obj2 : obj1;
+        float speedSq = velX[mover] * velX[mover] + velY[mover] * velY[mover];
+        if (speedSq < WAKE_SPEED * WAKE_SPEED) {
+            contactCount[mover]++;
+            return;
+        }
+    }
+
+    contactCount[obj1]++;
+    contactCount[obj2]++;
+}
+
+/// <summary>
+/// Tests each of the first <c>owners</c> lanes of a batch against every lane after it and gathers the
+/// contacts found into the accumulators. Nothing moves until <c>applyContacts</c>, so the lanes stay
+/// current and every contact sees the state from the start of the pass.
+/// </summary>
+/// <param name="batch">A sealed batch from the broadphase.</param>
+/// <param name="owners">Number of leading lanes to test.</param>
+/// <param name="scratch">The calling worker's scratch space.</param>
+void Solver::gatherBatch(CandidateBatch& batch, int owners, CollisionScratch& scratch)
+{
+    long long pairTests = 0;
+
+    for (int i = 0; i < owners; i++) {
+        int obj1 = batch.index[i];
+        int lane = NarrowPhase::nextOverlap(batch, i + 1, batch.x[i], batch.y[i], batch.radius[i]);
+        while (lane < batch.size) {
+            gatherContact(obj1, batch.index[lane]);
+            lane = NarrowPhase::nextOverlap(batch, lane + 1, batch.x[i], batch.y[i], batch.radius[i]);
         }
+        pairTests += batch.size - i - 1;
+    }
+
+    scratch.pairTests += pairTests;
+}
 
-        // begin collision checks within kernel
-        for (int i = 0; i < kernelObjs.size(); i++) {
-            for (int j = i + 1; j < kernelObjs.size(); j++) {
-                Circle* obj1 = kernelObjs.at(i);
-                Circle* obj2 = kernelObjs.at(j);
-                Vec2D posDiff12;
-                Vec2D::subtract(posDiff12, obj1->pos, obj2->pos);
-
-                // no overlap, therefore no collision, so skip
-                if (posDiff12.length() >= obj1->radius + obj2->radius) continue;
-
-                /*
-                Calculate new velocities using equations for two-dimensional
-                collision with two moving objects
-
-                Equations in vector representation can be
-                found @ https://en.wikipedia.org/wiki/Elastic_collision
-                */
-                Vec2D velDiff12, posDiffScaled12;
-                Vec2D::subtract(velDiff12, obj1->vel, obj2->vel);
-                float scalar1 = (2.0f * obj2->mass / (obj1->mass + obj2->mass))
-                    * Vec2D::dot(velDiff12, posDiff12)
-                    / (posDiff12.length() * posDiff12.length());
-                Vec2D::scale(posDiffScaled12, posDiff12, scalar1);
-
-                Vec2D posDiff21, velDiff21, posDiffScaled21;
-                Vec2D::subtract(posDiff21, obj2->pos, obj1->pos);
-                Vec2D::subtract(velDiff21, obj2->vel, obj1->vel);
-                float scalar2 = (2.0f * obj1->mass / (obj1->mass + obj2->mass))
-                    * Vec2D::dot(velDiff21, posDiff21)
-                    / (posDiff21.length() * posDiff21.length());
-                Vec2D::scale(posDiffScaled21, posDiff21, scalar2);
-
-                /*
-                Update velocities after computing both to avoid using new v1
-                in calculation for new v2
-                */
-                Vec2D::subtract(obj1->vel, obj1->vel, posDiffScaled12);
-                Vec2D::subtract(obj2->vel, obj2->vel, posDiffScaled21);
-
-                /*
-                Update positions by shifting each object by half the overlap
-                in opposite directions along the collision axis
-                */
-                float overlap = obj1->radius + obj2->radius - posDiff12.length();
-
-                Vec2D updatePos1, updatePos2;
-                Vec2D::scale(updatePos1, posDiff12, 0.5f * overlap / posDiff12.length());
-                obj1->pos.add(updatePos1);
-
-                Vec2D::scale(updatePos2, posDiff21, 0.5f * overlap / posDiff21.length());
-                obj2->pos.add(updatePos2);
-
-                //Set collision status for velocity scaling later
-                obj1->collided = true; obj2->collided = true;
+/// <summary>
+/// Works out the same response as <c>resolveCollision</c> and <c>resolveStaticCollision</c> for two
+/// objects, but adds it to their accumulators instead of applying it. The velocity change is scaled
+/// by one over the larger contact count of the two, so both objects get the same share and the pair's
+/// momentum is kept. Only the two objects' entries are written, which the broadphase schedule keeps to
+/// one worker at a time.
+/// </summary>
+/// <param name="obj1">Index of the first object.</param>
+/// <param name="obj2">Index of the second object.</param>
+void Solver::gatherContact(int obj1, int obj2)
+{
+    const float* posX = objects.posX.data();
+    const float* posY = objects.posY.data();
+    const float* velX = objects.velX.data();
+    const float* velY = objects.velY.data();
+    const float* mass = objects.mass.data();
+    const float* radius = objects.radius.data();
+    const std::uint8_t* asleep = objects.asleep.data();
+
+    if (asleep[obj1] && asleep[obj2]) return;
+
+    float dx = posX[obj1] - posX[obj2];
+    float dy = posY[obj1] - posY[obj2];
+    float distSq = dx * dx + dy * dy;
+    float radiusSum = radius[obj1] + radius[obj2];
+
+    if (distSq >= radiusSum * radiusSum || distSq == 0.f) return;
+
+    float invDist = 1.f / std::sqrt(distSq);
+
+    // a slow mover bounces off a sleeper, which stays asleep and untouched
+    if (asleep[obj1] || asleep[obj2]) {
+        int sleeper = asleep[obj1] ? obj1 : obj2;
+        int mover = asleep[obj1] ? obj2 : obj1;
+        float speedSq = velX[mover] * velX[mover] + velY[mover] * velY[mover];
+
+        if (speedSq < WAKE_SPEED * WAKE_SPEED) {
+            float sign = (mover == obj1) ? 1.f : -1.f;
+            float nx = sign * dx;
+            float ny = sign * dy;
+            float approach = (velX[mover] * nx + velY[mover] * ny) * invDist * invDist;
+            if (approach < 0.f) {
+                float share = 1.f / float(contactCount[mover]);
+                contactImpulseX[mover] -= 2.f * approach * share * nx;
+                contactImpulseY[mover] -= 2.f * approach * share * ny;
             }
+            float shift = radiusSum * invDist - 1.f;
+            contactShiftX[mover] += nx * shift;
+            contactShiftY[mover] += ny * shift;
+            return;
         }
+
+        // still static to every other contact of this pass, woken once they are applied
+        contactWake[sleeper] = 1;
     }
+
+    float dot12 = (velX[obj1] - velX[obj2]) * dx + (velY[obj1] - velY[obj2]) * dy;
+    float share = 1.f / float(std::max(contactCount[obj1], contactCount[obj2]));
+    float impulse = 2.0f * dot12 * invDist * invDist / (mass[obj1] + mass[obj2]) * share;
+    float scalar1 = mass[obj2] * impulse;
+    float scalar2 = mass[obj1] * impulse;
+    contactImpulseX[obj1] -= scalar1 * dx;
+    contactImpulseY[obj1] -= scalar1 * dy;
+    contactImpulseX[obj2] += scalar2 * dx;
+    contactImpulseY[obj2] += scalar2 * dy;
+
+    float shift = 0.5f * (radiusSum * invDist - 1.f);
+    contactShiftX[obj1] += dx * shift;
+    contactShiftY[obj1] += dy * shift;
+    contactShiftX[obj2] -= dx * shift;
+    contactShiftY[obj2] -= dy * shift;
 }
 
 /// <summary>
-/// Calls the <c>update</c> function on all objects.
+/// Applies the contacts gathered by <c>gatherBatch</c>, in parallel over contiguous chunks of objects.
+/// Position corrections are summed, as each is already only half the overlap. Velocity changes arrive
+/// already shared out: every one of them reflects the same starting velocity, so their full sum would
+/// bounce an object with several contacts several times over, and <c>gatherContact</c> scales each by
+/// the larger contact count of its pair. An isolated pair gets exactly the response
+/// <c>resolveCollision</c> would give. The sums are added up in the order the broadphase found the
+/// pairs, so two broadphases that find them in different orders agree only up to rounding.
 /// </summary>
+void Solver::applyContacts()
+{
+    int objectCount = objects.size();
+    int threadCount = workers.getThreadCount();
+    float* posX = objects.posX.data();
+    float* posY = objects.posY.data();
+    float* velX = objects.velX.data();
+    float* velY = objects.velY.data();
+    std::uint8_t* collided = objects.collided.data();
+
+    workers.run([&](int thread) {
+        int first = int((long long)objectCount * thread / threadCount);
+        int last = int((long long)objectCount * (thread + 1) / threadCount);
+
+        // no branches on the common path, so the loop vectorises
+        for (int i = first; i < last; i++) {
+            posX[i] += contactShiftX[i];
+            posY[i] += contactShiftY[i];
+            velX[i] += contactImpulseX[i];
+            velY[i] += contactImpulseY[i];
+            collided[i] |= std::uint8_t(contactCount[i] > 0);
+        }
+        for (int i = first; i < last; i++) {
+            if (!contactWake[i]) continue;
+            objects.asleep[i] = 0;
+            objects.calmTime[i] = 0.f;
+        }
+    });
+}
+
+/// <summary>
+/// Advances every object by one substep using Velocity-Verlet integration.
+/// </summary>
+/// <param name="subdt">The elapsed time of one substep, in seconds.</param>
 void Solver::updateObjects(float subdt)
 {
-    for (auto &object : objects) { object.update(subdt); }
+    VV_PROFILE_PHASE(profiler, ProfilePhase::Integrate);
+
+    /*
+    Equations for Velocity-Verlet integration can be
+    found @ https://en.wikipedia.org/wiki/Verlet_integration
+    */
+    for (int i = 0; i < objects.size(); i++)
+    {
+        if (objects.asleep[i]) continue;
+
+        // calculate v(t+0.5*dt)
+        float halfVX = objects.velX[i] + objects.aclX[i] * 0.5f * subdt;
+        float halfVY = objects.velY[i] + objects.aclY[i] * 0.5f * subdt;
+
+        // calculate new position
+        objects.posX[i] += halfVX * subdt;
+        objects.posY[i] += halfVY * subdt;
+
+        // calculate new velocity
+        objects.velX[i] = halfVX + objects.aclX[i] * 0.5f * subdt;
+        objects.velY[i] = halfVY + objects.aclY[i] * 0.5f * subdt;
+    }
 }
 
 /// <summary>
@@ -170,15 +559,18 @@ void Solver::updateObjects(float subdt)
 /// </summary>
 void Solver::applyRestitution()
 {
+    VV_PROFILE_PHASE(profiler, ProfilePhase::Restitution);
+
     /*
     Applying coefficient of restitution within applyCollisions() loop
     without a collided flag resulted in it being applied multiple times 
     for a single collision
     */
-    for (auto& obj : objects) {
-        if (obj.collided) {
-            obj.vel.scale(obj.restitutionCoeff);
-            obj.collided = false;
+    for (int i = 0; i < objects.size(); i++) {
+        if (objects.collided[i]) {
+            objects.velX[i] *= objects.restitution[i];
+            objects.velY[i] *= objects.restitution[i];
+            objects.collided[i] = 0;
         }
     }
 }
@@ -187,7 +579,7 @@ void Solver::applyRestitution()
 /// Adds a <c>Circle</c> object to the solver environment.
 /// </summary>
 /// <param name="obj"></param>
-void Solver::addObject(const Circle &obj){ objects.push_back(obj); }
+void Solver::addObject(const Circle &obj){ objects.add(obj); }
 
 void Solver::addSpawner(const Spawner& spawner) { spawners.push_back(spawner); }
 
@@ -196,49 +588,358 @@ void Solver::addSpawner(const Spawner& spawner) { spawners.push_back(spawner); }
 /// </summary>
 void Solver::updateSolver(float dt)
 {
-    if (paused) return;
-    float subdt = dt / float(SUBSTEPS);
+    if (restartPending.exchange(false)) {
+        objects.clear();
+
+        // a deterministic run starts over exactly as it began
+        if (DETERMINISTIC) {
+            seedPending = true;
+            framesSinceReorder = 0;
+            for (Spawner& spawner : spawners) { spawner.elapsed = 0.f; }
+        }
+    }
+    if (seedPending.exchange(false)) rng.seed(SEED);
+    if (requestedBroadphase != activeBroadphase) {
+        activeBroadphase = requestedBroadphase;
+        if (activeBroadphase == BroadphaseKind::Sweep) broadphase = &sweepBroadphase;
+        else if (activeBroadphase == BroadphaseKind::Hash) broadphase = &hashBroadphase;
+        else broadphase = &gridBroadphase;
+        broadphase->reset();
+    }
+    if (wakePending.exchange(false)) {
+        std::fill(objects.asleep.begin(), objects.asleep.end(), 0);
+        std::fill(objects.calmTime.begin(), objects.calmTime.end(), 0.f);
+        asleepCount = 0;
+    }
+    int capacity = reservePending.exchange(0);
+    if (capacity > 0) objects.reserve(capacity);
+
+    // the range may have been changed between frames
+    broadphase->setRadiusRange(MIN_RADIUS, MAX_RADIUS);
+
+    // reorder between frames, so no per-frame state holds object indices
+    if (REORDER_INTERVAL > 0 && !paused) {
+        framesSinceReorder++;
+        if (isReorderDue(framesSinceReorder)) reorderObjects();
+    }
+
+    // remembered so the renderer can interpolate between this frame and the next
+    frameStartX.assign(objects.posX.begin(), objects.posX.end());
+    frameStartY.assign(objects.posY.begin(), objects.posY.end());
+
+    if (paused) {
+        publishSnapshot();
+        return;
+    }
 
-    for (int substep = 0; substep < SUBSTEPS; substep++)
+    auto frameClock = std::chrono::steady_clock::now();
+    frameSubsteps = ADAPTIVE_SUBSTEPS ? chooseSubsteps(dt) : SUBSTEPS;
+    float subdt = dt / float(frameSubsteps);
+    float migrated = 0.f;
+
+    for (int substep = 0; substep < frameSubsteps; substep++)
     {
         applyGravity();
-        BOUNDS.applyBounds(objects);
+        {
+            VV_PROFILE_PHASE(profiler, ProfilePhase::Bounds);
+            BOUNDS.applyBounds(objects);
+        }
         applyCollisions();
+        migrated += broadphase->getMigrationFraction();
         applyRestitution();
         updateObjects(subdt);
     }
 
-    if (!autoSpawning) return;
+    migrationFraction = migrated / float(frameSubsteps);
+
+    if (SLEEPING) updateSleep(dt);
+    if (autoSpawning) spawnObjects(dt);
+    if (recorder.isRecording()) {
+        VV_PROFILE_PHASE(profiler, ProfilePhase::Record);
+        recorder.capture(objects, BOUNDS, frameCount + 1, dt);
+    }
+
+#if VV_PROFILING
+    auto frameTime = std::chrono::steady_clock::now() - frameClock;
+    profiler.endFrame(std::chrono::duration_cast<std::chrono::nanoseconds>(frameTime).count());
+#endif
+
+    frameCount++;
+    stateHash = DETERMINISTIC ? objects.hash() : 0;
+    publishSnapshot();
+}
+
+/// <summary>
+/// Copies the current and frame-start positions, radii and colours of every object into a free snapshot slot and hands it to the renderer.
+/// </summary>
+void Solver::publishSnapshot()
+{
+    renderSnapshots.writeSlot().capture(objects, frameStartX, frameStartY, BOUNDS, frameCount);
+    renderSnapshots.publish();
+}
+
+/// <summary>
+/// Picks the fewest substeps, between <c>MIN_SUBSTEPS</c> and <c>SUBSTEPS</c>, for which the fastest
+/// object moves no more than <c>CFL_LIMIT</c> of the minimum radius per substep. Gravity's gain over the
+/// frame is added to the fastest speed so objects that are speeding up are not under-stepped.
+/// </summary>
+/// <param name="dt">Length of the frame about to be simulated, in seconds.</param>
+int Solver::chooseSubsteps(float dt)
+{
+    int objectCount = objects.size();
+    int threadCount = workers.getThreadCount();
+    const float* velX = objects.velX.data();
+    const float* velY = objects.velY.data();
+
+    // each worker reduces one contiguous chunk, then the partial maxima are combined here
+    workers.run([&](int thread) {
+        int first = int((long long)objectCount * thread / threadCount);
+        int last = int((long long)objectCount * (thread + 1) / threadCount);
+        float maxSpeedSq = 0.f;
+        for (int i = first; i < last; i++) {
+            maxSpeedSq = std::max(maxSpeedSq, velX[i] * velX[i] + velY[i] * velY[i]);
+        }
+        collisionScratch[thread].maxSpeedSq = maxSpeedSq;
+    });
+
+    float maxSpeedSq = 0.f;
+    for (auto& scratch : collisionScratch) { maxSpeedSq = std::max(maxSpeedSq, scratch.maxSpeedSq); }
+
+    float gravity = std::sqrt(GRAVITY.x() * GRAVITY.x() + GRAVITY.y() * GRAVITY.y());
+    float travel = (std::sqrt(maxSpeedSq) + gravity * dt) * dt;
+    float allowed = CFL_LIMIT * float(std::max(MIN_RADIUS, 1));
+
+    int upper = std::max(SUBSTEPS, 1);
+    int lower = std::clamp(MIN_SUBSTEPS, 1, upper);
+    float needed = std::min(std::ceil(travel / allowed), float(upper));
+    return std::max(int(needed), lower);
+}
+
+/// <summary>
+/// Puts calm contact islands to sleep. An object is calm once it has stayed within <c>SLEEP_DRIFT</c>
+/// of one spot for <c>SLEEP_TIME</c>; resting objects jitter by a few pixels every substep, so
+/// their speed says little, but they do not go anywhere. Touching calm or sleeping objects form an
+/// island, and an island sleeps only when none of its members touches an object fast enough to wake it.
+/// </summary>
+/// <param name="dt">Length of the frame just simulated, in seconds.</param>
+void Solver::updateSleep(float dt)
+{
+    VV_PROFILE_PHASE(profiler, ProfilePhase::Sleep);
+
+    int objectCount = objects.size();
+    float* calmTime = objects.calmTime.data();
+    std::uint8_t* asleep = objects.asleep.data();
+
+    int newlyCalm = 0;      // awake objects that became calm this frame
+    int heldCalm = 0;       // awake objects calm for longer, held awake by a fast neighbour
+    for (int i = 0; i < objectCount; i++) {
+        if (asleep[i]) continue;
+        float dx = objects.posX[i] - objects.anchorX[i];
+        float dy = objects.posY[i] - objects.anchorY[i];
+        if (dx * dx + dy * dy > SLEEP_DRIFT * SLEEP_DRIFT) {
+            objects.anchorX[i] = objects.posX[i];
+            objects.anchorY[i] = objects.posY[i];
+            calmTime[i] = 0.f;
+            continue;
+        }
+        bool wasCalm = calmTime[i] >= SLEEP_TIME;
+        calmTime[i] += dt;
+        if (calmTime[i] >= SLEEP_TIME) (wasCalm ? heldCalm : newlyCalm)++;
+    }
+
+    // islands only change when an awake object has become calm; islands held awake are retried now and
+    // then, as their fast neighbours may have slowed down without becoming calm themselves
+    bool retryHeld = heldCalm > 0 && frameCount % SLEEP_RETRY_FRAMES == 0;
+    if (newlyCalm > 0 || retryHeld) {
+        auto settled = [&](int i) { return asleep[i] || calmTime[i] >= SLEEP_TIME; };
+        auto fast = [&](int i) {
+            return objects.velX[i] * objects.velX[i] + objects.velY[i] * objects.velY[i] >= WAKE_SPEED * WAKE_SPEED;
+        };
+
+        islandParent.resize(objectCount);
+        islandBlocked.assign(objectCount, 0);
+        for (int i = 0; i < objectCount; i++) { islandParent[i] = i; }
+
+        const float contactSlack = 1.f;     // px, gap still counted as a resting contact
+        auto link = [&](int a, int b) {
+            const float* posX = objects.posX.data();
+            const float* posY = objects.posY.data();
+            float dx = posX[a] - posX[b];
+            float dy = posY[a] - posY[b];
+            float reach = objects.radius[a] + objects.radius[b] + contactSlack;
+            if (dx * dx + dy * dy >= reach * reach) return;
+
+            bool settledA = settled(a);
+            bool settledB = settled(b);
+            if (settledA && settledB) {
+                int rootA = findIsland(a);
+                int rootB = findIsland(b);
+                if (rootA != rootB) islandParent[std::max(rootA, rootB)] = std::min(rootA, rootB);
+            }
+            else if (settledA && fast(b)) islandBlocked[a] = 1;
+            else if (settledB && fast(a)) islandBlocked[b] = 1;
+        };
+
+        broadphase->update(objects);
+        broadphase->forEachNearPair(objects, contactSlack, link);
+
+        for (int i = 0; i < objectCount; i++) {
+            if (islandBlocked[i]) islandBlocked[findIsland(i)] = 1;
+        }
+        for (int i = 0; i < objectCount; i++) {
+            if (asleep[i] || !settled(i) || islandBlocked[findIsland(i)]) continue;
+            asleep[i] = 1;
+            objects.velX[i] = 0.f;
+            objects.velY[i] = 0.f;
+        }
+    }
+
+    asleepCount = int(std::count(objects.asleep.begin(), objects.asleep.end(), std::uint8_t(1)));
+}
+
+/// <summary>
+/// Sorts the objects in memory into the order the active broadphase visits them (for the grid, level by
+/// level, then column by column and bottom to top within a column, as also for the hash grid; for the
+/// sweep, along its axis), so
+/// nearby objects sit close together and each worker's stripes or chunks map to one contiguous block
+/// of every attribute array.
+/// </summary>
+void Solver::reorderObjects()
+{
+    VV_PROFILE_PHASE(profiler, ProfilePhase::Partition);
+
+    // a fresh update lists every object in the order the broadphase visits them, which is exactly the new order
+    broadphase->update(objects);
+    broadphase->getTraversalOrder(reorderScratch);
+    objects.permute(reorderScratch);
+
+    // every broadphase holds the old indices, so their next update must start from scratch
+    gridBroadphase.reset();
+    sweepBroadphase.reset();
+    hashBroadphase.reset();
+
+    framesSinceReorder = 0;
+    reorderCount++;
+}
+
+/// <summary>
+/// Whether the objects are reordered at the start of a frame: once every <c>REORDER_INTERVAL</c> frames,
+/// or earlier when the broadphase reports them scattered. The disorder scan reads every object, so it
+/// is only run every <c>DISORDER_CHECK_FRAMES</c> frames.
+/// </summary>
+/// <param name="frames">Frames since the last reorder, counting the one starting.</param>
+bool Solver::isReorderDue(int frames) const
+{
+    if (frames >= REORDER_INTERVAL) return true;
+    return frames % DISORDER_CHECK_FRAMES == 0 && broadphase->getDisorder() >= REORDER_DISORDER;
+}
+
+/// <summary>
+/// Finds the root of an object's island, halving the path on the way.
+/// </summary>
+/// <param name="obj"></param>
+/// <returns>Index of the island's representative object.</returns>
+int Solver::findIsland(int obj)
+{
+    while (islandParent[obj] != obj) {
+        islandParent[obj] = islandParent[islandParent[obj]];
+        obj = islandParent[obj];
+    }
+    return obj;
+}
+
+/// <summary>
+/// Wakes every sleeping object at the start of the next frame. Safe to call from the UI thread; used
+/// whenever a parameter that could disturb a resting object changes.
+/// </summary>
+void Solver::wakeAll() { wakePending = true; }
+
+/// <summary>
+/// Fires every active spawner whose interval has elapsed, up to <c>MAX_OBJECTS</c>. Intervals are
+/// measured in wall time, or in simulated time when <c>DETERMINISTIC</c> is set, so a run does not
+/// depend on how fast frames were computed.
+/// </summary>
+/// <param name="dt">Length of the frame just simulated, in seconds.</param>
+void Solver::spawnObjects(float dt)
+{
+    VV_PROFILE_PHASE(profiler, ProfilePhase::Spawn);
+
     for (Spawner& spawner : spawners) {
         if (objects.size() >= MAX_OBJECTS) break;
 
-        if (spawner.active && spawner.timer.getElapsedTime().asSeconds() >= spawner.interval) {
+        spawner.elapsed += dt;
+        float elapsed = DETERMINISTIC ? spawner.elapsed : spawner.timer.getElapsedTime().asSeconds();
+        if (spawner.active && elapsed >= spawner.interval) {
             Circle circle = Circle();
-            Circle::generateRandomObject(circle);
+            Circle::generateRandomObject(circle, MIN_RADIUS, MAX_RADIUS, rng);
             circle.pos = spawner.pos;
             circle.vel = spawner.vel;
             addObject(circle);
             spawner.timer.restart();
+            spawner.elapsed = 0.f;
         }
     }
 }
 
-void Solver::restart() { objects.clear(); }
+/// <summary>
+/// Removes every object. Deferred to the start of the next <c>updateSolver</c> so it is safe to call from the UI thread.
+/// </summary>
+void Solver::restart() { restartPending = true; }
 void Solver::togglePause() { paused = !paused; }
 void Solver::setAutoSpawning(bool value) { autoSpawning = value; }
 void Solver::setFramerate(int framerate) { FRAMERATE = framerate; }
 void Solver::setSubsteps(int substeps) { SUBSTEPS = substeps; }
+void Solver::setMinSubsteps(int substeps) { MIN_SUBSTEPS = substeps; }
+void Solver::setAdaptiveSubsteps(bool adaptive) { ADAPTIVE_SUBSTEPS = adaptive; }
+void Solver::setJacobiContacts(bool jacobi) { JACOBI_CONTACTS = jacobi; }
+void Solver::setDeterministic(bool deterministic) { DETERMINISTIC = deterministic; }
+
+/// <summary>
+/// Reseeds the random objects from the start of the next frame. Safe to call from the UI thread.
+/// </summary>
+/// <param name="seed"></param>
+void Solver::setSeed(unsigned seed)
+{
+    SEED = seed;
+    seedPending = true;
+}
+
+void Solver::setReorderInterval(int frames) { REORDER_INTERVAL = std::max(frames, 0); }
+
+void Solver::setSleeping(bool sleeping)
+{
+    SLEEPING = sleeping;
+    wakeAll();
+}
 
+/// <summary>
+/// Caps the objects spawners may create. Room for them is reserved at the start of the next frame,
+/// as reserving moves every object array. Safe to call from the UI thread.
+/// </summary>
+/// <param name="maxObjects"></param>
 void Solver::setMaxObjects(int maxObjects)
 {
     MAX_OBJECTS = maxObjects;
-    objects.reserve(MAX_OBJECTS);
+    reservePending = maxObjects;
 }
 
+/// <summary>
+/// Setter for <c>MIN_RADIUS</c>.
+/// </summary>
+/// <param name="radius">Clamped to between 1 and <c>MAX_RADIUS</c> inclusive.</param>
+void Solver::setMinRadius(int radius) { MIN_RADIUS = std::clamp(radius, 1, MAX_RADIUS); }
+
+/// <summary>
+/// Setter for <c>MAX_RADIUS</c>.
+/// </summary>
+/// <param name="radius">Clamped to between <c>MIN_RADIUS</c> and <c>Circle::RADIUS_LIMIT</c> inclusive.</param>
+void Solver::setMaxRadius(int radius) { MAX_RADIUS = std::clamp(radius, MIN_RADIUS, Circle::RADIUS_LIMIT); }
+
 void Solver::setGravity(float x, float y) 
 { 
     GRAVITY.setX(x); 
     GRAVITY.setY(y); 
+    wakeAll();
 }
 
 void Solver::addSpawner(SpawnerDTO dto)
@@ -285,3 +986,238 @@ void Solver::retrieveSpawnerIDs()
     }
     emit returnSpawnerIDs(spawnerIDs);
 }
+
+/// <summary>
+/// Writes the complete state of the simulation to a checkpoint file, see Checkpoint.h. Call from the
+/// solver thread between frames, or before it starts.
+/// </summary>
+/// <param name="path"></param>
+/// <returns>False, with the reason on stderr, if the file could not be written.</returns>
+bool Solver::saveCheckpoint(const std::string& path) const
+{
+    CheckpointHeader header = {};
+    header.frameCount = frameCount;
+    header.stateHash = stateHash;
+    header.objectCount = objects.size();
+    header.spawnerCount = int(spawners.size());
+    header.nextObjectId = objects.nextId;
+    header.gravityX = GRAVITY.x();
+    header.gravityY = GRAVITY.y();
+    header.boundsLeft = BOUNDS.left;
+    header.boundsRight = BOUNDS.right;
+    header.boundsUp = BOUNDS.up;
+    header.boundsDown = BOUNDS.down;
+    const GridHierarchy& grids = gridBroadphase.getGrids();
+    header.gridWidth = grids.getWidth();
+    header.gridHeight = grids.getHeight();
+    header.minRadius = MIN_RADIUS;
+    header.maxRadius = MAX_RADIUS;
+    header.framerate = FRAMERATE;
+    header.substeps = SUBSTEPS;
+    header.minSubsteps = MIN_SUBSTEPS;
+    header.cflLimit = CFL_LIMIT;
+    header.sleepDrift = SLEEP_DRIFT;
+    header.sleepTime = SLEEP_TIME;
+    header.wakeSpeed = WAKE_SPEED;
+    header.reorderInterval = REORDER_INTERVAL;
+    header.reorderDisorder = REORDER_DISORDER;
+    // the disorder that triggers an early reorder is lost with the broadphase, so one due next frame is saved as due
+    header.framesSinceReorder = REORDER_INTERVAL > 0 && isReorderDue(framesSinceReorder + 1) ? std::max(framesSinceReorder, REORDER_INTERVAL - 1) : framesSinceReorder;
+    header.maxObjects = MAX_OBJECTS;
+    header.spawnInterval = SPAWN_INTERVAL;
+    header.seed = SEED;
+    header.broadphase = std::uint32_t(activeBroadphase);
+    header.gridMultiLevel = grids.multiLevel;
+    header.gridIncremental = grids.incremental;
+    header.adaptiveSubsteps = ADAPTIVE_SUBSTEPS;
+    header.sleeping = SLEEPING;
+    header.jacobiContacts = JACOBI_CONTACTS;
+    header.deterministic = DETERMINISTIC;
+    header.autoSpawning = autoSpawning;
+    header.paused = paused;
+    header.sweepAxis = std::uint8_t(sweepBroadphase.getAxis());
+
+    std::vector<CheckpointSpawner> spawnerRecords;
+    std::string spawnerIds;
+    for (const Spawner& spawner : spawners) {
+        CheckpointSpawner record = {};
+        record.posX = spawner.pos.x();
+        record.posY = spawner.pos.y();
+        record.velX = spawner.vel.x();
+        record.velY = spawner.vel.y();
+        record.interval = spawner.interval;
+        record.elapsed = spawner.elapsed;
+        record.idOffset = std::uint32_t(spawnerIds.size());
+        record.idLength = std::uint32_t(spawner.id.size());
+        record.colour[0] = spawner.colour.r;
+        record.colour[1] = spawner.colour.g;
+        record.colour[2] = spawner.colour.b;
+        record.colour[3] = spawner.colour.a;
+        record.active = spawner.active;
+        record.visible = spawner.visible;
+        spawnerRecords.push_back(record);
+        spawnerIds += spawner.id;
+    }
+
+    // the engine's own text form is the only portable way to save its state
+    std::ostringstream rngState;
+    rngState << rng;
+    std::string rngText = rngState.str();
+
+    CheckpointWriter writer;
+    writer.add(CheckpointSection::PosX, objects.posX);
+    writer.add(CheckpointSection::PosY, objects.posY);
+    writer.add(CheckpointSection::VelX, objects.velX);
+    writer.add(CheckpointSection::VelY, objects.velY);
+    writer.add(CheckpointSection::AclX, objects.aclX);
+    writer.add(CheckpointSection::AclY, objects.aclY);
+    writer.add(CheckpointSection::Mass, objects.mass);
+    writer.add(CheckpointSection::Radius, objects.radius);
+    writer.add(CheckpointSection::Restitution, objects.restitution);
+    writer.add(CheckpointSection::Collided, objects.collided);
+    writer.add(CheckpointSection::Asleep, objects.asleep);
+    writer.add(CheckpointSection::CalmTime, objects.calmTime);
+    writer.add(CheckpointSection::AnchorX, objects.anchorX);
+    writer.add(CheckpointSection::AnchorY, objects.anchorY);
+    writer.add(CheckpointSection::Colour, objects.colour);
+    writer.add(CheckpointSection::Id, objects.id);
+    writer.add(CheckpointSection::Spawners, spawnerRecords);
+    writer.add(CheckpointSection::SpawnerIds, spawnerIds);
+    writer.add(CheckpointSection::Rng, rngText);
+
+    std::string error;
+    if (!writer.write(path, header, error)) {
+        std::cerr << "Checkpoint not saved: " << error << std::endl;
+        return false;
+    }
+    return true;
+}
+
+/// <summary>
+/// Replaces the complete state of the simulation with that of a checkpoint file, see Checkpoint.h.
+/// Call from the solver thread between frames, or before it starts; the renderer sees the restored
+/// objects from the next frame. The radius range this solver draws new objects from is restored too.
+/// </summary>
+/// <param name="path"></param>
+/// <returns>False, with the reason on stderr and the solver unchanged, if the file could not be read.</returns>
+bool Solver::loadCheckpoint(const std::string& path)
+{
+    CheckpointFile file;
+    std::string error;
+    if (!file.open(path, error)) {
+        std::cerr << "Checkpoint not loaded: " << error << std::endl;
+        return false;
+    }
+    const CheckpointHeader& header = file.header();
+
+    // check every section before anything is replaced
+    std::uint64_t objectCount = std::uint64_t(std::max(header.objectCount, 0));
+    std::uint64_t spawnerCount = std::uint64_t(std::max(header.spawnerCount, 0));
+    const CheckpointSectionEntry& ids = header.sections[int(CheckpointSection::SpawnerIds)];
+    const CheckpointSectionEntry& rngEntry = header.sections[int(CheckpointSection::Rng)];
+    const auto* records = static_cast<const CheckpointSpawner*>(file.section(CheckpointSection::Spawners, sizeof(CheckpointSpawner), spawnerCount));
+    const char* idBytes = static_cast<const char*>(file.section(CheckpointSection::SpawnerIds, 1, ids.count));
+    const char* rngBytes = static_cast<const char*>(file.section(CheckpointSection::Rng, 1, rngEntry.count));
+    bool valid = header.broadphase < std::uint32_t(BroadphaseKind::Count) && records && idBytes && rngBytes;
+    for (int s = 0; s <= int(CheckpointSection::AnchorY) && valid; s++) {
+        std::uint32_t elementSize = (s == int(CheckpointSection::Collided) || s == int(CheckpointSection::Asleep)) ? 1 : 4;
+        valid = file.section(CheckpointSection(s), elementSize, objectCount) != nullptr;
+    }
+    valid = valid && file.section(CheckpointSection::Colour, sizeof(sf::Color), objectCount)
+        && file.section(CheckpointSection::Id, sizeof(std::uint32_t), objectCount);
+    for (std::uint64_t i = 0; i < spawnerCount && valid; i++) {
+        valid = std::uint64_t(records[i].idOffset) + records[i].idLength <= ids.count;
+    }
+    std::mt19937 restoredRng;
+    if (valid) {
+        std::istringstream rngState(std::string(rngBytes, size_t(rngEntry.count)));
+        rngState >> restoredRng;
+        valid = !rngState.fail();
+    }
+    if (!valid) {
+        std::cerr << "Checkpoint not loaded: " << path << " does not describe a valid solver state" << std::endl;
+        return false;
+    }
+
+    file.read(CheckpointSection::PosX, objectCount, objects.posX);
+    file.read(CheckpointSection::PosY, objectCount, objects.posY);
+    file.read(CheckpointSection::VelX, objectCount, objects.velX);
+    file.read(CheckpointSection::VelY, objectCount, objects.velY);
+    file.read(CheckpointSection::AclX, objectCount, objects.aclX);
+    file.read(CheckpointSection::AclY, objectCount, objects.aclY);
+    file.read(CheckpointSection::Mass, objectCount, objects.mass);
+    file.read(CheckpointSection::Radius, objectCount, objects.radius);
+    file.read(CheckpointSection::Restitution, objectCount, objects.restitution);
+    file.read(CheckpointSection::Collided, objectCount, objects.collided);
+    file.read(CheckpointSection::Asleep, objectCount, objects.asleep);
+    file.read(CheckpointSection::CalmTime, objectCount, objects.calmTime);
+    file.read(CheckpointSection::AnchorX, objectCount, objects.anchorX);
+    file.read(CheckpointSection::AnchorY, objectCount, objects.anchorY);
+    file.read(CheckpointSection::Colour, objectCount, objects.colour);
+    file.read(CheckpointSection::Id, objectCount, objects.id);
+    objects.nextId = header.nextObjectId;
+
+    spawners.clear();
+    for (std::uint64_t i = 0; i < spawnerCount; i++) {
+        const CheckpointSpawner& record = records[i];
+        Spawner spawner(std::string(idBytes + record.idOffset, record.idLength),
+                        Vec2D(record.posX, record.posY), Vec2D(record.velX, record.velY),
+                        record.interval, record.active != 0, record.visible != 0);
+        spawner.elapsed = record.elapsed;
+        spawner.colour = sf::Color(record.colour[0], record.colour[1], record.colour[2], record.colour[3]);
+        spawners.push_back(spawner);
+    }
+
+    // widen first so neither setter clamps against the previous range
+    MIN_RADIUS = 1;
+    setMaxRadius(header.maxRadius);
+    setMinRadius(header.minRadius);
+
+    GRAVITY = Vec2D(header.gravityX, header.gravityY);
+    BOUNDS = RectBounds(header.boundsLeft, header.boundsRight, header.boundsUp, header.boundsDown);
+    GridHierarchy& grids = gridBroadphase.getGrids();
+    grids.setGridSize(header.gridWidth, header.gridHeight);
+    grids.multiLevel = header.gridMultiLevel != 0;
+    grids.incremental = header.gridIncremental != 0;
+    FRAMERATE = header.framerate;
+    SUBSTEPS = header.substeps;
+    MIN_SUBSTEPS = header.minSubsteps;
+    CFL_LIMIT = header.cflLimit;
+    SLEEP_DRIFT = header.sleepDrift;
+    SLEEP_TIME = header.sleepTime;
+    WAKE_SPEED = header.wakeSpeed;
+    REORDER_INTERVAL = header.reorderInterval;
+    REORDER_DISORDER = header.reorderDisorder;
+    MAX_OBJECTS = header.maxObjects;
+    SPAWN_INTERVAL = header.spawnInterval;
+    SEED = header.seed;
+    ADAPTIVE_SUBSTEPS = header.adaptiveSubsteps != 0;
+    SLEEPING = header.sleeping != 0;
+    JACOBI_CONTACTS = header.jacobiContacts != 0;
+    DETERMINISTIC = header.deterministic != 0;
+    autoSpawning = header.autoSpawning != 0;
+    paused = header.paused != 0;
+    rng = restoredRng;
+
+    // every broadphase starts over from the restored objects; the grid and hash keep no order of
+    // their own, and the sweep orders ties by index, so only its axis has to carry over
+    activeBroadphase = BroadphaseKind(header.broadphase);
+    requestedBroadphase = activeBroadphase;
+    if (activeBroadphase == BroadphaseKind::Sweep) broadphase = &sweepBroadphase;
+    else if (activeBroadphase == BroadphaseKind::Hash) broadphase = &hashBroadphase;
+    else broadphase = &gridBroadphase;
+    gridBroadphase.reset();
+    sweepBroadphase.resume(header.sweepAxis);
+    hashBroadphase.reset();
+
+    // the file is the whole state, so nothing requested before the load still applies
+    restartPending = false;
+    wakePending = false;
+    seedPending = false;
+    reservePending = 0;
+    frameCount = header.frameCount;
+    framesSinceReorder = header.framesSinceReorder;
+    asleepCount = int(std::count(objects.asleep.begin(), objects.asleep.end(), std::uint8_t(1)));
+    stateHash = header.stateHash;
+    return true;
+}
@@ -0,0 +1,261 @@
+#include "../include/SweepBroadphase.h"
+#include <algorithm>
+#include <cstdlib>
+#include <numeric>
+
+/// <summary>
+/// Constructs an empty sweep. The axis and order are set up on the first update.
+/// </summary>
+SweepBroadphase::SweepBroadphase()
+{
+    axis = 0;
+    movedCount = 0;
+    orderValid = false;
+    keepAxis = false;
+}
+
+const char* SweepBroadphase::getName() const { return "sweep"; }
+
+/// <summary>
+/// Extents are taken from each object's own radius, so the range is not needed.
+/// </summary>
+void SweepBroadphase::setRadiusRange(int, int) {}
+
+/// <summary>
+/// Forgets the order, so the next update sorts from scratch. Must be called whenever objects are
+/// reordered in memory.
+/// </summary>
+void SweepBroadphase::reset()
+{
+    orderValid = false;
+    keepAxis = false;
+}
+
+/// <summary>
+/// Forgets the order like <c>reset</c>, but has the next sort sweep along the given axis instead of
+/// choosing one, so a restored run sweeps along the axis the saved run was using.
+/// </summary>
+/// <param name="sweepAxis">0 for x, 1 for y, as returned by <c>getAxis</c>.</param>
+void SweepBroadphase::resume(int sweepAxis)
+{
+    axis = sweepAxis ? 1 : 0;
+    keepAxis = true;
+    orderValid = false;
+}
+
+/// <summary>
+/// The axis of the current order: 0 for x, 1 for y.
+/// </summary>
+int SweepBroadphase::getAxis() const { return axis; }
+
+/// <summary>
+/// Sorts every object from scratch along the axis the objects are spread furthest on, or along the
+/// kept axis after <c>resume</c>. Ties are ordered by index, as the insertion sort in <c>update</c>
+/// keeps them.
+/// </summary>
+/// <param name="objects"></param>
+void SweepBroadphase::rebuildOrder(const ParticleStore& objects)
+{
+    const int objectCount = objects.size();
+
+    // sweeping along the wider spread keeps the windows short
+    if (objectCount > 0 && !keepAxis) {
+        auto spread = [&](const AlignedVector<float>& pos) {
+            auto range = std::minmax_element(pos.begin(), pos.end());
+            return *range.second - *range.first;
+        };
+        axis = spread(objects.posY) > spread(objects.posX) ? 1 : 0;
+    }
+    keepAxis = false;
+
+    const float* pos = axis ? objects.posY.data() : objects.posX.data();
+    order.resize(objectCount);
+    std::iota(order.begin(), order.end(), 0);
+    std::sort(order.begin(), order.end(), [&](int a, int b) {
+        float lowerA = pos[a] - objects.radius[a];
+        float lowerB = pos[b] - objects.radius[b];
+        return lowerA < lowerB || (lowerA == lowerB && a < b);
+    });
+
+    movedCount = objectCount;
+    orderValid = true;
+}
+
+/// <summary>
+/// Brings the order up to date with the objects' positions. New objects are appended and sorted in
+/// with the rest; an insertion sort then repairs the order left by the previous update, moving each
+/// entry only as far as it has overtaken its neighbours. Equal lower ends are ordered by index, so
+/// the result depends only on the positions and the axis, not on the order it was repaired from.
+/// </summary>
+/// <param name="objects"></param>
+void SweepBroadphase::update(const ParticleStore& objects)
+{
+    const int objectCount = objects.size();
+
+    // a rebuild or new objects count as moved, the insertion sort below adds the rest
+    if (!orderValid || objectCount < int(order.size())) rebuildOrder(objects);
+    else {
+        movedCount = objectCount - int(order.size());
+        for (int i = int(order.size()); i < objectCount; i++) { order.push_back(i); }
+    }
+
+    const float* pos = axis ? objects.posY.data() : objects.posX.data();
+    const float* radius = objects.radius.data();
+
+    lower.resize(objectCount);
+    for (int k = 0; k < objectCount; k++) { lower[k] = pos[order[k]] - radius[order[k]]; }
+
+    for (int k = 1; k < objectCount; k++) {
+        float key = lower[k];
+        int obj = order[k];
+        int j = k;
+        while (j > 0 && (lower[j - 1] > key || (lower[j - 1] == key && order[j - 1] > obj))) {
+            lower[j] = lower[j - 1];
+            order[j] = order[j - 1];
+            j--;
+        }
+        if (j != k) {
+            lower[j] = key;
+            order[j] = obj;
+            movedCount++;
+        }
+    }
+
+    // an entry's window ends at the first entry starting past its upper end
+    windowEnd.resize(objectCount);
+    for (int k = 0; k < objectCount; k++) {
+        float upper = pos[order[k]] + radius[order[k]];
+        windowEnd[k] = int(std::upper_bound(lower.begin() + k + 1, lower.end(), upper) - lower.begin());
+    }
+
+    buildChunks();
+}
+
+/// <summary>
+/// Splits the sorted entries into chunks for the two-colour schedule. A chunk is at least
+/// <c>MIN_CHUNK</c> entries and is widened until it covers every window of the chunk before it, so
+/// chunk c never reaches into chunk c + 2 and every other chunk can run at the same time. The
+/// boundaries depend only on the order, never on the thread count.
+/// </summary>
+void SweepBroadphase::buildChunks()
+{
+    const int entryCount = int(order.size());
+
+    chunkStart.assign(1, 0);
+    int previousReach = 0;
+    int start = 0;
+    while (start < entryCount) {
+        int end = std::min(std::max(start + MIN_CHUNK, previousReach), entryCount);
+        int reach = end;
+        for (int k = start; k < end; k++) { reach = std::max(reach, windowEnd[k]); }
+        chunkStart.push_back(end);
+        previousReach = reach;
+        start = end;
+    }
+}
+
+/// <summary>
+/// Hands each sorted entry to the resolver with its window, in parallel over chunks of the order.
+/// Chunks of the same colour (every other chunk) never share objects; colours run one after the other
+/// with the pool's join as the barrier.
+/// </summary>
+/// <param name="objects">The objects of the last <c>update</c>, read again for current positions.</param>
+/// <param name="workers"></param>
+/// <param name="resolve"></param>
+void SweepBroadphase::collide(const ParticleStore& objects, WorkerPool& workers, const BatchResolver& resolve)
+{
+    prepareBatches(workers);
+
+    const float* posX = objects.posX.data();
+    const float* posY = objects.posY.data();
+    const float* radius = objects.radius.data();
+    int chunkCount = int(chunkStart.size()) - 1;
+    int threadCount = workers.getThreadCount();
+
+    for (int colour = 0; colour < 2; colour++) {
+        int colourChunkCount = (chunkCount - colour + 1) / 2;
+
+        // windows are long where objects crowd, so chunks are shared out by their lane tests, not by count
+        std::vector<long long>& workPrefix = chunkWork[colour];
+        workPrefix.assign(1, 0);
+        if (threadCount > 1) {
+            for (int c = 0; c < colourChunkCount; c++) {
+                int chunk = 2 * c + colour;
+                long long work = 0;
+                for (int k = chunkStart[chunk]; k < chunkStart[chunk + 1]; k++) { work += windowEnd[k] - k - 1; }
+                workPrefix.push_back(workPrefix.back() + work);
+            }
+        }
+
+        // each worker takes one contiguous run of this colour's chunks
+        workers.run([&](int thread) {
+            CandidateBatch& batch = threadBatches[thread].batch;
+            int first = 0;
+            int last = colourChunkCount;
+            if (threadCount > 1) splitByWork(workPrefix, thread, threadCount, first, last);
+            for (int c = first; c < last; c++) {
+                int chunk = 2 * c + colour;
+                for (int k = chunkStart[chunk]; k < chunkStart[chunk + 1]; k++) {
+                    if (windowEnd[k] == k + 1) continue;
+
+                    // the entry and its window are consecutive in the order, so they form one contiguous range
+                    batch.clear();
+                    batch.gather(order.data() + k, order.data() + windowEnd[k], posX, posY, radius);
+                    batch.seal();
+                    resolve(thread, batch, 1);
+                }
+            }
+        });
+    }
+}
+
+/// <summary>
+/// Visits every pair of objects whose extents on the sweep axis come within <c>slack</c> of each
+/// other, once each, from the entry that starts first.
+/// </summary>
+/// <param name="objects">The objects of the last <c>update</c>.</param>
+/// <param name="slack">Gap, in px, still counted as near.</param>
+/// <param name="visit"></param>
+void SweepBroadphase::forEachNearPair(const ParticleStore& objects, float slack, const PairVisitor& visit)
+{
+    const float* pos = axis ? objects.posY.data() : objects.posX.data();
+    const int entryCount = int(order.size());
+
+    for (int k = 0; k < entryCount; k++) {
+        float upper = pos[order[k]] + objects.radius[order[k]] + slack;
+        for (int j = k + 1; j < entryCount && lower[j] <= upper; j++) { visit(order[k], order[j]); }
+    }
+}
+
+/// <summary>
+/// Share of objects the last update moved in the order. Objects added since the previous update
+/// count as moved.
+/// </summary>
+/// <returns>A value between 0 and 1, or 0 before the first update.</returns>
+float SweepBroadphase::getMigrationFraction() const
+{
+    return order.empty() ? 0.f : float(std::min(movedCount, int(order.size()))) / float(order.size());
+}
+
+/// <summary>
+/// How scattered the objects are in memory relative to the sorted order: the share of consecutive
+/// sorted entries more than <c>LOCAL_SPAN</c> object indices apart. Entries with nearly equal lower
+/// ends swap places on every small move, so exact adjacency as in <c>Grid::getDisorder</c> would
+/// report a freshly reordered store as scattered after a single substep.
+/// </summary>
+/// <returns>0 when objects are stored in sorted order, close to 1 when they are in no spatial order.</returns>
+float SweepBroadphase::getDisorder() const
+{
+    if (order.size() < 2) return 0.f;
+    int scattered = 0;
+    for (size_t k = 1; k < order.size(); k++) {
+        scattered += (std::abs(order[k] - order[k - 1]) > LOCAL_SPAN);
+    }
+    return float(scattered) / float(order.size() - 1);
+}
+
+/// <summary>
+/// Lists every object in sorted order.
+/// </summary>
+/// <param name="order">Overwritten with a permutation of the object indices from the last update.</param>
+void SweepBroadphase::getTraversalOrder(std::vector<int>& order) const { order = this->order; }
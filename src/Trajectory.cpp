@@ -0,0 +1,317 @@
+#include "../include/Trajectory.h"
+#include "../include/ParticleStore.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#include <QtCore/qbytearray.h>
+
+/// <summary>
+/// Rounds a value to a whole number of steps, saturating at the range of a 32-bit integer.
+/// </summary>
+/// <returns>The step count as the bits of an int32, so differences wrap like unsigned integers.</returns>
+static std::uint32_t quantise(float value, float step)
+{
+    double steps = std::round(double(value) / double(step));
+    if (!(steps == steps)) return 0;    // NaN
+    steps = std::clamp(steps, -2147483648.0, 2147483647.0);
+    return std::uint32_t(std::int32_t(steps));
+}
+
+static float dequantise(std::uint32_t steps, float step) { return float(std::int32_t(steps)) * step; }
+
+static std::uint32_t packColour(const sf::Color& colour)
+{
+    return std::uint32_t(colour.r) | (std::uint32_t(colour.g) << 8) | (std::uint32_t(colour.b) << 16) | (std::uint32_t(colour.a) << 24);
+}
+
+static sf::Color unpackColour(std::uint32_t bits)
+{
+    return sf::Color(sf::Uint8(bits), sf::Uint8(bits >> 8), sf::Uint8(bits >> 16), sf::Uint8(bits >> 24));
+}
+
+/*
+====================================================================================
+TRAJECTORY FRAME struct
+====================================================================================
+*/
+
+/// <summary>
+/// Getter for the number of objects in the frame.
+/// </summary>
+int TrajectoryFrame::size() const { return int(posX.size()); }
+
+/// <summary>
+/// Sets the length of every array, keeping their capacity.
+/// </summary>
+/// <param name="count"></param>
+void TrajectoryFrame::resize(int count)
+{
+    id.resize(count);
+    posX.resize(count);
+    posY.resize(count);
+    velX.resize(count);
+    velY.resize(count);
+    radius.resize(count);
+    colour.resize(count);
+}
+
+/// <summary>
+/// Overwrites the frame with the current state of <c>objects</c>.
+/// </summary>
+/// <param name="objects"></param>
+/// <param name="bounds"></param>
+/// <param name="frameNumber"></param>
+/// <param name="frameTime">Seconds of simulated time per solver frame.</param>
+void TrajectoryFrame::capture(const ParticleStore& objects, const RectBounds& bounds, long long frameNumber, float frameTime)
+{
+    resize(objects.size());
+    std::copy(objects.id.begin(), objects.id.end(), id.begin());
+    std::copy(objects.posX.begin(), objects.posX.end(), posX.begin());
+    std::copy(objects.posY.begin(), objects.posY.end(), posY.begin());
+    std::copy(objects.velX.begin(), objects.velX.end(), velX.begin());
+    std::copy(objects.velY.begin(), objects.velY.end(), velY.begin());
+    std::copy(objects.radius.begin(), objects.radius.end(), radius.begin());
+    std::copy(objects.colour.begin(), objects.colour.end(), colour.begin());
+
+    this->bounds = bounds;
+    this->frameTime = frameTime;
+    frame = frameNumber;
+}
+
+/*
+====================================================================================
+TRAJECTORY CODEC class
+====================================================================================
+*/
+
+/// <summary>
+/// Constructs a codec at the start of a chunk.
+/// </summary>
+/// <param name="positionStep">px per quantisation step of positions and radii.</param>
+/// <param name="velocityStep">px/s per quantisation step of velocities.</param>
+TrajectoryCodec::TrajectoryCodec(float positionStep, float velocityStep)
+{
+    this->positionStep = positionStep;
+    this->velocityStep = velocityStep;
+}
+
+/// <summary>
+/// Forgets the previous frame, so the next one is coded as a keyframe. Called at the start of every chunk.
+/// </summary>
+void TrajectoryCodec::reset()
+{
+    for (std::vector<std::uint32_t>& field : previous) { field.clear(); }
+}
+
+/// <summary>
+/// Writes a value in 7-bit groups, least significant first, with the top bit set on all but the last byte.
+/// </summary>
+/// <returns>One past the last byte written, at most 5 bytes on.</returns>
+unsigned char* TrajectoryCodec::writeVarint(unsigned char* out, std::uint32_t value)
+{
+    while (value >= 0x80) {
+        *out++ = (unsigned char)(value | 0x80);
+        value >>= 7;
+    }
+    *out++ = (unsigned char)value;
+    return out;
+}
+
+/// <summary>
+/// Reads a value written by <c>writeVarint</c>.
+/// </summary>
+/// <returns>False if the value runs past <c>end</c> or is longer than 5 bytes.</returns>
+bool TrajectoryCodec::readVarint(const unsigned char*& cursor, const unsigned char* end, std::uint32_t& value)
+{
+    value = 0;
+    for (int shift = 0; shift < 35 && cursor < end; shift += 7) {
+        unsigned char byte = *cursor++;
+        value |= std::uint32_t(byte & 0x7f) << shift;
+        if (!(byte & 0x80)) return true;
+    }
+    return false;
+}
+
+/// <summary>
+/// Appends one frame, coded against the previous frame passed to <c>encode</c> since the last <c>reset</c>.
+/// </summary>
+/// <param name="frame"></param>
+/// <param name="out">The chunk's frames so far.</param>
+void TrajectoryCodec::encode(const TrajectoryFrame& frame, std::string& out)
+{
+    int count = frame.size();
+    TrajectoryFrameHeader header = { frame.frame, std::uint32_t(count),
+                                     frame.bounds.left, frame.bounds.right, frame.bounds.up, frame.bounds.down, frame.frameTime };
+
+    // sized for the worst case and trimmed afterwards, so the varints are written through a plain pointer
+    size_t start = out.size();
+    out.resize(start + sizeof header + size_t(count) * FIELD_COUNT * 5);
+    unsigned char* cursor = reinterpret_cast<unsigned char*>(&out[start]);
+    std::memcpy(cursor, &header, sizeof header);
+    cursor += sizeof header;
+
+    auto code = [&](int field, auto valueOf) {
+        std::vector<std::uint32_t>& last = previous[field];
+        last.resize(count, 0);
+        for (int i = 0; i < count; i++) {
+            std::uint32_t value = valueOf(i);
+            std::int32_t delta = std::int32_t(value - last[i]);
+            last[i] = value;
+            // zigzag, so small negative differences stay small
+            cursor = writeVarint(cursor, (std::uint32_t(delta) << 1) ^ std::uint32_t(delta >> 31));
+        }
+    };
+    code(0, [&](int i) { return frame.id[i]; });
+    code(1, [&](int i) { return quantise(frame.posX[i], positionStep); });
+    code(2, [&](int i) { return quantise(frame.posY[i], positionStep); });
+    code(3, [&](int i) { return quantise(frame.velX[i], velocityStep); });
+    code(4, [&](int i) { return quantise(frame.velY[i], velocityStep); });
+    code(5, [&](int i) { return quantise(frame.radius[i], positionStep); });
+    code(6, [&](int i) { return packColour(frame.colour[i]); });
+
+    out.resize(size_t(cursor - reinterpret_cast<unsigned char*>(&out[0])));
+}
+
+/// <summary>
+/// Reads the next frame of a decompressed chunk, coded against the previous frame read since the last <c>reset</c>.
+/// </summary>
+/// <param name="cursor">Start of the frame; moved past it.</param>
+/// <param name="end">End of the chunk's frames.</param>
+/// <param name="frame">Overwritten with the decoded frame.</param>
+/// <returns>False if the data ends early or is malformed.</returns>
+bool TrajectoryCodec::decode(const unsigned char*& cursor, const unsigned char* end, TrajectoryFrame& frame)
+{
+    TrajectoryFrameHeader header;
+    if (size_t(end - cursor) < sizeof header) return false;
+    std::memcpy(&header, cursor, sizeof header);
+    cursor += sizeof header;
+
+    // every value takes at least one byte
+    if (std::uint64_t(header.objectCount) * FIELD_COUNT > std::uint64_t(end - cursor)) return false;
+    int count = int(header.objectCount);
+    frame.frame = header.frame;
+    frame.frameTime = header.frameTime;
+    frame.bounds = RectBounds(header.boundsLeft, header.boundsRight, header.boundsUp, header.boundsDown);
+    frame.resize(count);
+
+    bool valid = true;
+    auto decodeField = [&](int field, auto store) {
+        std::vector<std::uint32_t>& last = previous[field];
+        last.resize(count, 0);
+        for (int i = 0; i < count && valid; i++) {
+            std::uint32_t zigzag;
+            valid = readVarint(cursor, end, zigzag);
+            std::uint32_t value = last[i] + ((zigzag >> 1) ^ (0u - (zigzag & 1)));
+            last[i] = value;
+            store(i, value);
+        }
+    };
+    decodeField(0, [&](int i, std::uint32_t v) { frame.id[i] = v; });
+    decodeField(1, [&](int i, std::uint32_t v) { frame.posX[i] = dequantise(v, positionStep); });
+    decodeField(2, [&](int i, std::uint32_t v) { frame.posY[i] = dequantise(v, positionStep); });
+    decodeField(3, [&](int i, std::uint32_t v) { frame.velX[i] = dequantise(v, velocityStep); });
+    decodeField(4, [&](int i, std::uint32_t v) { frame.velY[i] = dequantise(v, velocityStep); });
+    decodeField(5, [&](int i, std::uint32_t v) { frame.radius[i] = dequantise(v, positionStep); });
+    decodeField(6, [&](int i, std::uint32_t v) { frame.colour[i] = unpackColour(v); });
+    return valid;
+}
+
+/*
+====================================================================================
+TRAJECTORY FILE class
+====================================================================================
+*/
+
+TrajectoryFile::TrajectoryFile()
+{
+    header = nullptr;
+    footer = {};
+    index = nullptr;
+}
+
+/// <summary>
+/// Maps a trajectory and checks that this build can read it and that it was closed properly.
+/// </summary>
+/// <param name="path"></param>
+/// <param name="error">Set to the reason when the file cannot be used.</param>
+/// <returns>True if the file is mapped and its index can be used.</returns>
+bool TrajectoryFile::open(const std::string& path, std::string& error)
+{
+    // recordings can be far larger than memory, so pages are only read as chunks are decoded
+    if (!map.open(path, false, error)) return false;
+
+    const unsigned char* data = map.getData();
+    std::uint64_t size = map.getSize();
+    header = reinterpret_cast<const TrajectoryHeader*>(data);
+    footer = {};
+    index = nullptr;
+
+    // the map starts on a page, so the header can be read in place; a damaged file can end on any byte, so the footer is copied
+    const bool sized = size >= sizeof(TrajectoryHeader) + sizeof(TrajectoryFooter);
+    if (sized) std::memcpy(&footer, data + size - sizeof(TrajectoryFooter), sizeof footer);
+
+    if (!sized || std::memcmp(header->magic, "VVTRAJ", 7) != 0) error = path + " is not a trajectory";
+    else if (header->byteOrder != TRAJECTORY_BYTE_ORDER) error = path + " was written on a machine of the other byte order";
+    else if (header->version != TRAJECTORY_VERSION) error = path + " is trajectory version " + std::to_string(header->version) + ", expected " + std::to_string(TRAJECTORY_VERSION);
+    else if (std::memcmp(footer.magic, "VVTREND", 8) != 0) error = path + " has no index; the recording was not stopped";
+    else if (footer.indexOffset > size - sizeof(TrajectoryFooter) || footer.indexOffset % TRAJECTORY_INDEX_ALIGNMENT != 0
+             || footer.frameCount != (size - sizeof(TrajectoryFooter) - footer.indexOffset) / sizeof(TrajectoryIndexEntry)) error = path + " has a damaged index";
+    else {
+        // findFrame binary searches the index, so it must be in frame order
+        index = reinterpret_cast<const TrajectoryIndexEntry*>(data + footer.indexOffset);
+        for (std::uint64_t i = 0; i < footer.frameCount && error.empty(); i++) {
+            if (index[i].chunkOffset + sizeof(TrajectoryChunkHeader) > footer.indexOffset
+                || (i > 0 && index[i].frame < index[i - 1].frame)) error = path + " has a damaged index";
+        }
+    }
+
+    if (!error.empty()) {
+        map.close();
+        return false;
+    }
+    return true;
+}
+
+const TrajectoryHeader& TrajectoryFile::getHeader() const { return *header; }
+long long TrajectoryFile::getFrameCount() const { return (long long)footer.frameCount; }
+long long TrajectoryFile::getDroppedCount() const { return (long long)footer.droppedFrames; }
+
+/// <summary>
+/// Getter for the index entry of a recorded frame.
+/// </summary>
+/// <param name="frameIndex">Must be a value between 0 and <c>getFrameCount() - 1</c> inclusive.</param>
+const TrajectoryIndexEntry& TrajectoryFile::getEntry(long long frameIndex) const { return index[frameIndex]; }
+
+/// <summary>
+/// Finds the last recorded frame at or before a solver frame, by binary search of the index.
+/// </summary>
+/// <param name="solverFrame"></param>
+/// <returns>Its position in the index, or 0 if every recorded frame is later.</returns>
+long long TrajectoryFile::findFrame(long long solverFrame) const
+{
+    const TrajectoryIndexEntry* end = index + footer.frameCount;
+    const TrajectoryIndexEntry* after = std::upper_bound(index, end, solverFrame,
+        [](long long frame, const TrajectoryIndexEntry& entry) { return frame < entry.frame; });
+    return after == index ? 0 : (long long)(after - index) - 1;
+}
+
+/// <summary>
+/// Decompresses the chunk holding a recorded frame. Its frames are then read with a freshly reset
+/// <c>TrajectoryCodec</c>, starting <c>getEntry(frameIndex).frameInChunk</c> frames before the one asked for.
+/// </summary>
+/// <param name="frameIndex"></param>
+/// <param name="frames">Overwritten with the chunk's decompressed frames.</param>
+/// <returns>False if the chunk is damaged.</returns>
+bool TrajectoryFile::readChunk(long long frameIndex, std::string& frames) const
+{
+    std::uint64_t offset = index[frameIndex].chunkOffset;
+    TrajectoryChunkHeader chunk;
+    std::memcpy(&chunk, map.getData() + offset, sizeof chunk);
+    if (chunk.compressedSize > footer.indexOffset - offset - sizeof chunk) return false;
+
+    QByteArray raw = qUncompress(map.getData() + offset + sizeof chunk, qsizetype(chunk.compressedSize));
+    if (std::uint64_t(raw.size()) != chunk.rawSize) return false;
+    frames.assign(raw.constData(), size_t(raw.size()));
+    return true;
+}
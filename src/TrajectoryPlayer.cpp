@@ -0,0 +1,279 @@
+#include "../include/TrajectoryPlayer.h"
+#include <algorithm>
+#include <cmath>
+
+TrajectoryPlayer::TrajectoryPlayer() : codec(1.f, 1.f)
+{
+    for (int i = 0; i < SLOT_COUNT; i++) slotIndex[i] = EMPTY;
+    wantedIndex = 0;
+    stopping = false;
+    failed = false;
+    chunkOffset = 0;
+    cursor = 0;
+    nextIndex = 0;
+    snapshotIndex = -1;
+    snapshotStart = 0;
+    frameTime = 1.f / 60.f;
+    position = 0.0;
+    speed = 1.0;
+    paused = false;
+    buffering = true;
+}
+
+TrajectoryPlayer::~TrajectoryPlayer()
+{
+    {
+        std::lock_guard<std::mutex> lock(slotMutex);
+        stopping = true;
+    }
+    wake.notify_one();
+    if (decoder.joinable()) decoder.join();
+}
+
+/// <summary>
+/// Opens a recording and starts decoding it from its first frame. A player opens one recording.
+/// </summary>
+/// <param name="path"></param>
+/// <param name="error">Set to the reason when the file cannot be played.</param>
+/// <returns>True if playback can start.</returns>
+bool TrajectoryPlayer::open(const std::string& path, std::string& error)
+{
+    if (decoder.joinable()) {
+        error = "a recording is already open";
+        return false;
+    }
+    if (!file.open(path, error)) return false;
+    if (file.getFrameCount() == 0) {
+        error = path + " has no frames";
+        return false;
+    }
+
+    const TrajectoryHeader& header = file.getHeader();
+    codec = TrajectoryCodec(header.positionStep, header.velocityStep);
+    position = double(getFirstFrame());
+    decoder = std::thread(&TrajectoryPlayer::decoderLoop, this);
+    return true;
+}
+
+/*
+====================================================================================
+Decoding, on the decoder thread
+====================================================================================
+*/
+
+/// <summary>
+/// Keeps the SLOT_COUNT frames from <c>wantedIndex</c> onwards decoded, nearest first, and parks
+/// once they all are.
+/// </summary>
+void TrajectoryPlayer::decoderLoop()
+{
+    std::unique_lock<std::mutex> lock(slotMutex);
+    while (!stopping) {
+        long long last = std::min(wantedIndex + SLOT_COUNT, file.getFrameCount());
+        long long index = -1;
+        for (long long i = wantedIndex; i < last && index < 0; i++) {
+            if (slotIndex[i % SLOT_COUNT] != i) index = i;
+        }
+        if (index < 0 || failed) {
+            wake.wait(lock);
+            continue;
+        }
+
+        // the slot held a frame outside the window, so the render thread will not read it meanwhile
+        int slot = int(index % SLOT_COUNT);
+        slotIndex[slot] = DECODING;
+        lock.unlock();
+        bool decoded = decodeFrame(index, frames[slot]);
+        lock.lock();
+
+        slotIndex[slot] = decoded ? index : EMPTY;
+        if (!decoded) failed = true;
+    }
+}
+
+/// <summary>
+/// Decodes one recorded frame. Frames after the last one decoded in the same chunk carry on from it;
+/// any other frame restarts from its chunk's keyframe.
+/// </summary>
+/// <param name="index">Position of the frame in the file's index.</param>
+/// <param name="frame">Overwritten with the decoded frame.</param>
+/// <returns>False if the chunk is damaged.</returns>
+bool TrajectoryPlayer::decodeFrame(long long index, TrajectoryFrame& frame)
+{
+    const TrajectoryIndexEntry& entry = file.getEntry(index);
+    if (entry.chunkOffset != chunkOffset || nextIndex > index) {
+        chunkOffset = 0;
+        if (!file.readChunk(index, chunk)) return false;
+        chunkOffset = entry.chunkOffset;
+        cursor = 0;
+        nextIndex = index - entry.frameInChunk;
+        codec.reset();
+    }
+
+    const unsigned char* data = reinterpret_cast<const unsigned char*>(chunk.data());
+    const unsigned char* end = data + chunk.size();
+    while (nextIndex <= index) {
+        TrajectoryFrame& target = nextIndex == index ? frame : skipped;
+        const unsigned char* read = data + cursor;
+        if (!codec.decode(read, end, target) || target.frame != file.getEntry(nextIndex).frame) {
+            chunkOffset = 0;
+            return false;
+        }
+        cursor = size_t(read - data);
+        nextIndex++;
+    }
+    return true;
+}
+
+/*
+====================================================================================
+Playback, on the render thread
+====================================================================================
+*/
+
+/// <summary>
+/// Checks whether a frame is decoded. Must be called with <c>slotMutex</c> held.
+/// </summary>
+bool TrajectoryPlayer::isDecoded(long long index) { return slotIndex[index % SLOT_COUNT] == index; }
+
+/// <summary>
+/// Moves playback on by an amount of real time and updates the snapshot to the new position. While
+/// the frames there are still being decoded the position holds and the last snapshot stays.
+/// </summary>
+/// <param name="seconds">Real time since the last call.</param>
+void TrajectoryPlayer::advance(float seconds)
+{
+    if (failed) return;
+
+    double target = position;
+    if (!paused && snapshotIndex >= 0) target += double(seconds) * speed / double(frameTime);
+    target = std::clamp(target, double(getFirstFrame()), double(getLastFrame()));
+
+    long long first = file.findFrame((long long)std::floor(target));
+    long long second = std::min(first + 1, file.getFrameCount() - 1);
+    bool ready;
+    {
+        std::lock_guard<std::mutex> lock(slotMutex);
+        if (wantedIndex != first) {
+            wantedIndex = first;
+            wake.notify_one();
+        }
+        ready = isDecoded(first) && isDecoded(second);
+    }
+
+    buffering = !ready;
+    if (!ready) return;
+
+    // both frames are in the window, which only this thread moves, so they stay put while read
+    position = target;
+    if (first != snapshotIndex) {
+        buildSnapshot(frames[first % SLOT_COUNT], frames[second % SLOT_COUNT]);
+        snapshotIndex = first;
+    }
+    if (position >= double(getLastFrame())) paused = true;
+}
+
+/// <summary>
+/// Fills the snapshot with the objects of the later frame, each starting from where it was in the
+/// earlier one. The solver reorders objects now and then, so objects are matched by id where their
+/// index changed; objects the earlier frame lacks start where they end.
+/// </summary>
+/// <param name="earlier"></param>
+/// <param name="later"></param>
+void TrajectoryPlayer::buildSnapshot(const TrajectoryFrame& earlier, const TrajectoryFrame& later)
+{
+    int count = later.size();
+    snapshot.posX.assign(later.posX.begin(), later.posX.end());
+    snapshot.posY.assign(later.posY.begin(), later.posY.end());
+    snapshot.radius.assign(later.radius.begin(), later.radius.end());
+    snapshot.colour.assign(later.colour.begin(), later.colour.end());
+    snapshot.previousX.resize(count);
+    snapshot.previousY.resize(count);
+    snapshot.bounds = later.bounds;
+    snapshot.frame = later.frame;
+    snapshotStart = earlier.frame;
+    frameTime = earlier.frameTime > 0.f ? earlier.frameTime : frameTime;
+
+    // the solver never removes objects but when it is cleared, and a cleared solver reuses ids
+    int earlierCount = later.size() >= earlier.size() ? earlier.size() : 0;
+    bool mapped = false;
+    for (int i = 0; i < count; i++) {
+        int match = -1;
+        if (i < earlierCount && earlier.id[i] == later.id[i]) match = i;
+        else {
+            if (!mapped) {
+                std::uint32_t maxId = 0;
+                for (int j = 0; j < earlierCount; j++) maxId = std::max(maxId, earlier.id[j]);
+                earlierIndex.assign(size_t(maxId) + 1, -1);
+                for (int j = 0; j < earlierCount; j++) earlierIndex[earlier.id[j]] = j;
+                mapped = true;
+            }
+            if (earlierCount > 0 && later.id[i] < earlierIndex.size()) match = earlierIndex[later.id[i]];
+        }
+        snapshot.previousX[i] = match >= 0 ? earlier.posX[match] : later.posX[i];
+        snapshot.previousY[i] = match >= 0 ? earlier.posY[match] : later.posY[i];
+    }
+}
+
+/// <summary>
+/// Getter for the snapshot of the frames around the playback position. It is empty until the
+/// first frame is decoded.
+/// </summary>
+const RenderSnapshot& TrajectoryPlayer::getSnapshot() const { return snapshot; }
+
+/// <summary>
+/// Getter for how far the playback position lies between the snapshot's previous and current
+/// positions, for <c>Renderer::renderSnapshot</c>.
+/// </summary>
+float TrajectoryPlayer::getAlpha() const
+{
+    if (snapshot.frame <= snapshotStart) return 0.f;
+    return float(std::clamp((position - double(snapshotStart)) / double(snapshot.frame - snapshotStart), 0.0, 1.0));
+}
+
+/// <summary>
+/// Pauses or resumes playback. Resuming at the last frame starts again from the first.
+/// </summary>
+void TrajectoryPlayer::togglePause()
+{
+    paused = !paused;
+    if (!paused && position >= double(getLastFrame())) seek(double(getFirstFrame()));
+}
+
+bool TrajectoryPlayer::isPaused() const { return paused; }
+bool TrajectoryPlayer::isBuffering() const { return buffering; }
+
+/// <summary>
+/// Getter for whether a damaged chunk stopped playback.
+/// </summary>
+bool TrajectoryPlayer::hasFailed() const { return failed; }
+
+/// <summary>
+/// Setter for the playback speed, as simulated time per real time.
+/// </summary>
+/// <param name="speed">Clamped to between MIN_SPEED and MAX_SPEED.</param>
+void TrajectoryPlayer::setSpeed(double speed) { this->speed = std::clamp(speed, MIN_SPEED, MAX_SPEED); }
+double TrajectoryPlayer::getSpeed() const { return speed; }
+
+/// <summary>
+/// Moves playback to a solver frame. The snapshot follows once the frames there are decoded, which
+/// takes at most one chunk of frames.
+/// </summary>
+/// <param name="solverFrame">Clamped to the recorded frames.</param>
+void TrajectoryPlayer::seek(double solverFrame)
+{
+    position = std::clamp(solverFrame, double(getFirstFrame()), double(getLastFrame()));
+}
+
+/// <summary>
+/// Getter for the playback position, in solver frames.
+/// </summary>
+double TrajectoryPlayer::getPosition() const { return position; }
+
+long long TrajectoryPlayer::getFirstFrame() const { return file.getEntry(0).frame; }
+long long TrajectoryPlayer::getLastFrame() const { return file.getEntry(file.getFrameCount() - 1).frame; }
+
+/// <summary>
+/// Getter for the seconds of simulated time per solver frame, as recorded with the shown frame.
+/// </summary>
+float TrajectoryPlayer::getFrameTime() const { return frameTime; }
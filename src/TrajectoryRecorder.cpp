@@ -0,0 +1,202 @@
+#include "../include/TrajectoryRecorder.h"
+#include <chrono>
+#include <cstring>
+#include <iostream>
+
+#include <QtCore/qbytearray.h>
+
+TrajectoryRecorder::TrajectoryRecorder() : codec(POSITION_STEP, VELOCITY_STEP)
+{
+    queueHead = 0;
+    queueTail = 0;
+    stopping = false;
+    recordedCount = 0;
+    droppedCount = 0;
+    failed = false;
+    recording = false;
+    interval = 1;
+    chunkFrameCount = 0;
+    chunkCount = 0;
+    writtenBytes = 0;
+}
+
+TrajectoryRecorder::~TrajectoryRecorder() { stop(); }
+
+/// <summary>
+/// Opens a trajectory file and starts the writer thread. Stops any recording already running first.
+/// Call from the solver thread, or before it starts.
+/// </summary>
+/// <param name="path"></param>
+/// <param name="interval">Solver frames per recorded frame; only frames whose number is a multiple of it are captured.</param>
+/// <returns>False, with the reason on stderr, if the file could not be created.</returns>
+bool TrajectoryRecorder::start(const std::string& path, int interval)
+{
+    stop();
+
+    file.open(path, std::ios::binary | std::ios::trunc);
+    if (!file) {
+        std::cerr << "Trajectory not recorded: cannot open " << path << " for writing" << std::endl;
+        return false;
+    }
+
+    this->path = path;
+    this->interval = std::max(interval, 1);
+    queueHead = 0;
+    queueTail = 0;
+    stopping = false;
+    recordedCount = 0;
+    droppedCount = 0;
+    failed = false;
+    codec.reset();
+    chunkFrames.clear();
+    chunkFrameCount = 0;
+    chunkCount = 0;
+    writtenBytes = 0;
+    index.clear();
+
+    TrajectoryHeader header = {};
+    std::memcpy(header.magic, "VVTRAJ", 6);
+    header.version = TRAJECTORY_VERSION;
+    header.byteOrder = TRAJECTORY_BYTE_ORDER;
+    header.positionStep = POSITION_STEP;
+    header.velocityStep = VELOCITY_STEP;
+    header.chunkFrames = CHUNK_FRAMES;
+    header.frameInterval = std::uint32_t(this->interval);
+    writeBytes(&header, sizeof header);
+
+    recording = true;
+    writer = std::thread(&TrajectoryRecorder::writerLoop, this);
+    return true;
+}
+
+/// <summary>
+/// Lets the writer thread finish the queued frames, then writes the index and footer and closes the
+/// file. Does nothing when not recording. Call from the thread that calls <c>capture</c>.
+/// </summary>
+void TrajectoryRecorder::stop()
+{
+    if (!recording) return;
+
+    {
+        std::lock_guard<std::mutex> lock(wakeMutex);
+        stopping = true;
+    }
+    wake.notify_one();
+    writer.join();
+    file.close();
+    recording = false;
+
+    if (failed) std::cerr << "Trajectory " << path << " is incomplete: the file could not be written" << std::endl;
+}
+
+/// <summary>
+/// Copies the objects into the queue for the writer thread. Never waits: if the writer is a full
+/// queue behind, the frame is dropped and counted instead. Call from the solver thread at the end
+/// of every frame.
+/// </summary>
+/// <param name="objects"></param>
+/// <param name="bounds"></param>
+/// <param name="frameNumber">Solver frames completed, including this one.</param>
+/// <param name="frameTime">Seconds of simulated time per solver frame.</param>
+void TrajectoryRecorder::capture(const ParticleStore& objects, const RectBounds& bounds, long long frameNumber, float frameTime)
+{
+    if (!recording || frameNumber % interval != 0) return;
+
+    unsigned long long head = queueHead.load(std::memory_order_relaxed);
+    if (head - queueTail.load(std::memory_order_acquire) >= QUEUE_FRAMES) {
+        droppedCount++;
+        return;
+    }
+    queue[head % QUEUE_FRAMES].capture(objects, bounds, frameNumber, frameTime);
+    queueHead.store(head + 1, std::memory_order_release);
+
+    // notified without the lock so the solver cannot block on it; the writer's timed wait covers a missed wake-up
+    wake.notify_one();
+}
+
+/// <summary>
+/// Writer thread: encodes queued frames into chunks until stopped, then flushes the last chunk and
+/// writes the index and footer.
+/// </summary>
+void TrajectoryRecorder::writerLoop()
+{
+    unsigned long long tail = queueTail.load(std::memory_order_relaxed);
+
+    while (true) {
+        bool finishing = stopping.load();
+        if (tail == queueHead.load(std::memory_order_acquire)) {
+            if (finishing) break;
+            std::unique_lock<std::mutex> lock(wakeMutex);
+            wake.wait_for(lock, std::chrono::milliseconds(10), [&] {
+                return stopping.load() || tail != queueHead.load(std::memory_order_acquire);
+            });
+            continue;
+        }
+
+        // each chunk starts from a keyframe, so it decodes without the ones before it
+        if (chunkFrameCount == 0) codec.reset();
+
+        const TrajectoryFrame& frame = queue[tail % QUEUE_FRAMES];
+        index.push_back(TrajectoryIndexEntry{ frame.frame, 0, std::uint32_t(chunkFrameCount), std::uint32_t(frame.size()) });
+        codec.encode(frame, chunkFrames);
+        queueTail.store(++tail, std::memory_order_release);
+        recordedCount++;
+
+        if (++chunkFrameCount == CHUNK_FRAMES || chunkFrames.size() >= size_t(CHUNK_BYTES)) writeChunk();
+    }
+
+    if (chunkFrameCount > 0) writeChunk();
+
+    // chunks end on any byte, so the index is padded onto its boundary
+    const char padding[TRAJECTORY_INDEX_ALIGNMENT] = {};
+    writeBytes(padding, (TRAJECTORY_INDEX_ALIGNMENT - writtenBytes % TRAJECTORY_INDEX_ALIGNMENT) % TRAJECTORY_INDEX_ALIGNMENT);
+
+    TrajectoryFooter footer = {};
+    footer.indexOffset = writtenBytes;
+    footer.frameCount = index.size();
+    footer.droppedFrames = std::uint64_t(droppedCount.load());
+    footer.chunkCount = chunkCount;
+    std::memcpy(footer.magic, "VVTREND", 7);
+    writeBytes(index.data(), index.size() * sizeof(TrajectoryIndexEntry));
+    writeBytes(&footer, sizeof footer);
+    file.flush();
+    if (!file) failed = true;
+}
+
+/// <summary>
+/// Compresses the current chunk's frames and appends them to the file, and points their index
+/// entries at the chunk.
+/// </summary>
+void TrajectoryRecorder::writeChunk()
+{
+    for (size_t i = index.size() - chunkFrameCount; i < index.size(); i++) { index[i].chunkOffset = writtenBytes; }
+
+    QByteArray compressed = qCompress(reinterpret_cast<const uchar*>(chunkFrames.data()), qsizetype(chunkFrames.size()), COMPRESSION_LEVEL);
+    TrajectoryChunkHeader header = { std::uint32_t(chunkFrameCount), 0, chunkFrames.size(), std::uint64_t(compressed.size()) };
+    writeBytes(&header, sizeof header);
+    writeBytes(compressed.constData(), std::uint64_t(compressed.size()));
+
+    chunkFrames.clear();
+    chunkFrameCount = 0;
+    chunkCount++;
+}
+
+/// <summary>
+/// Appends to the file, unless an earlier write failed.
+/// </summary>
+void TrajectoryRecorder::writeBytes(const void* data, std::uint64_t size)
+{
+    if (failed) return;
+    file.write(static_cast<const char*>(data), std::streamsize(size));
+    if (!file) failed = true;
+    writtenBytes += size;
+}
+
+bool TrajectoryRecorder::isRecording() const { return recording; }
+const std::string& TrajectoryRecorder::getPath() const { return path; }
+long long TrajectoryRecorder::getRecordedCount() const { return recordedCount; }
+
+/// <summary>
+/// Getter for the frames dropped since <c>start</c> because the writer thread was behind.
+/// </summary>
+long long TrajectoryRecorder::getDroppedCount() const { return droppedCount; }
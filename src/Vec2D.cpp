@@ -1,4 +1,5 @@
 #include "../include/Vec2D.h"
+#include <cmath>
 #include <sstream>
 
 
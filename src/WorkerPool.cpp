@@ -0,0 +1,122 @@
+#include "../include/WorkerPool.h"
+#include "../include/Profiler.h"
+#include <algorithm>
+#include <chrono>
+
+/// <summary>
+/// Constructs a pool of <c>threadCount</c> workers. The calling thread counts as worker 0,
+/// so only <c>threadCount - 1</c> threads are created. They live until the pool is destroyed.
+/// </summary>
+/// <param name="threadCount">Number of workers, including the caller. Clamped to at least 1.</param>
+WorkerPool::WorkerPool(int threadCount)
+{
+    task = nullptr;
+    generation = 0;
+    pending = 0;
+    stopping = false;
+
+    threadCount = std::max(threadCount, 1);
+    busyTimes.assign(threadCount, BusyTime());
+    for (int workerIdx = 1; workerIdx < threadCount; workerIdx++) {
+        threads.emplace_back(&WorkerPool::workerLoop, this, workerIdx);
+    }
+}
+
+/// <summary>
+/// Wakes all parked workers, tells them to exit, and joins them.
+/// </summary>
+WorkerPool::~WorkerPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    wake.notify_all();
+    for (auto& thread : threads) { thread.join(); }
+}
+
+/// <summary>
+/// Getter for the worker count.
+/// </summary>
+/// <returns>The number of workers, including the calling thread.</returns>
+int WorkerPool::getThreadCount() const { return int(threads.size()) + 1; }
+
+/// <summary>
+/// Runs <c>job(workerIdx)</c> once on every worker and blocks until all of them have returned.
+/// The caller runs <c>job(0)</c> itself instead of sleeping through it.
+/// </summary>
+/// <param name="job">Called with a worker index between 0 and <c>getThreadCount() - 1</c> inclusive.</param>
+void WorkerPool::run(const std::function<void(int)>& job)
+{
+    if (threads.empty()) { runTimed(job, 0); return; }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        task = &job;
+        pending = int(threads.size());
+        generation++;
+    }
+    wake.notify_all();
+
+    runTimed(job, 0);
+
+    std::unique_lock<std::mutex> lock(mutex);
+    done.wait(lock, [this]() { return pending == 0; });
+    task = nullptr;
+}
+
+/// <summary>
+/// Body of every pooled thread. Parks until a new job is published, runs it, reports back, and parks again.
+/// </summary>
+/// <param name="workerIdx">Index passed to each job run by this thread.</param>
+void WorkerPool::workerLoop(int workerIdx)
+{
+    unsigned seenGeneration = 0;
+
+    while (true) {
+        const std::function<void(int)>* job;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            wake.wait(lock, [&]() { return stopping || generation != seenGeneration; });
+            if (stopping) return;
+            seenGeneration = generation;
+            job = task;
+        }
+
+        runTimed(*job, workerIdx);
+
+        std::lock_guard<std::mutex> lock(mutex);
+        if (--pending == 0) done.notify_one();
+    }
+}
+
+/// <summary>
+/// Runs one worker's share of a job and adds its duration to that worker's busy time. Without
+/// VV_PROFILING the job is only run, and busy times stay 0.
+/// </summary>
+/// <param name="job"></param>
+/// <param name="workerIdx"></param>
+void WorkerPool::runTimed(const std::function<void(int)>& job, int workerIdx)
+{
+#if VV_PROFILING
+    auto start = std::chrono::steady_clock::now();
+    job(workerIdx);
+    auto elapsed = std::chrono::steady_clock::now() - start;
+    busyTimes[workerIdx].ns += std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count();
+#else
+    job(workerIdx);
+#endif
+}
+
+/// <summary>
+/// Zeroes the busy time of every worker. Call between jobs only.
+/// </summary>
+void WorkerPool::resetBusyTimes() { std::fill(busyTimes.begin(), busyTimes.end(), BusyTime()); }
+
+/// <summary>
+/// Time a worker has spent running jobs since the last <c>resetBusyTimes</c>. Call between jobs only;
+/// the join at the end of <c>run</c> makes every worker's time visible to the caller.
+/// </summary>
+/// <param name="workerIdx"></param>
+/// <returns>Busy time, in nanoseconds.</returns>
+long long WorkerPool::getBusyTime(int workerIdx) const { return busyTimes[workerIdx].ns; }
@@ -1,40 +1,50 @@
 #include "../include/Renderer.h"
 #include "../include/ControlPanel.h"
+#include "../include/TrajectoryPlayer.h"
 #include <iostream>
+#include <string>
 #include <SFML/Graphics.hpp>
 #include <SFML/System/Clock.hpp>
 #include <thread>
 #include <chrono>
+#include <algorithm>
+#include <cmath>
 #include <QtWidgets/qapplication.h>
 
 // button sprite resolution = 100x100
 
 
-int Circle::MAX_RADIUS = 20;
-int Circle::MIN_RADIUS = 10;
 //const int WINDOW_W = sf::VideoMode::getDesktopMode().width / 2;
 //const int WINDOW_H = sf::VideoMode::getDesktopMode().height * 0.8;
 const int WINDOW_W = 700;
 const int WINDOW_H = 700;
+const int RENDER_FRAMERATE = 60;        // window refresh cap, independent of the simulation rate
+const int MAX_STEPS_PER_FRAME = 5;      // solver steps one render frame may catch up on
+const std::string DEFAULT_CHECKPOINT = "quicksave.vvchk";   // written by F5 and read by F9 unless one was given on the command line
+const std::string TRAJECTORY_PATH = "trajectory.vvtraj";    // recorded while F6 is toggled on
+const float SEEK_SECONDS = 1.f;         // simulated time the arrow keys skip during playback
 
 
-void solverThread(Solver& solver, Renderer& renderer) 
+void solverThread(Solver& solver, Renderer& renderer, std::string checkpointPath, bool restored)
 {
-    int framerate = 60;
-    float frametime = 1 / float(framerate);
+    float accumulator = 0.f;            // simulation time owed to the solver, in seconds
 
     sf::Clock spawnTimer;
     sf::Clock frame;
     sf::Clock infoUpdate;
 
-    // configure solver parameters
-    solver.setBounds(RectBounds(0, WINDOW_W, 0, WINDOW_H));
-    solver.setSpawnInterval(0.1f);
+    // configure solver parameters, unless they came from a checkpoint
+    if (!restored) {
+        solver.setBounds(RectBounds(0, WINDOW_W, 0, WINDOW_H));
+        solver.setSpawnInterval(0.1f);
 
-    solver.addSpawner(Spawner("spawner", Vec2D(200, 200), Vec2D(1000, -1000), 0.2, true, true));
+        solver.addSpawner(Spawner("spawner", Vec2D(200, 200), Vec2D(1000, -1000), 0.2, true, true));
+    }
     // configure window parameters
-    sf::RenderWindow window(sf::VideoMode(WINDOW_W, WINDOW_H), "Simulation Window");
-    window.setFramerateLimit(solver.getFramerate());
+    unsigned windowW = unsigned(std::max(solver.getBounds()->right, 1));
+    unsigned windowH = unsigned(std::max(solver.getBounds()->down, 1));
+    sf::RenderWindow window(sf::VideoMode(windowW, windowH), "Simulation Window");
+    window.setFramerateLimit(RENDER_FRAMERATE);
     //window.setVisible(false);
     //window.setPosition(sf::Vector2i(0, 0));
 
@@ -49,6 +59,25 @@ void solverThread(Solver& solver, Renderer& renderer)
                 window.close();
             }
 
+            // quick save and load, between solver steps
+            if (event.type == sf::Event::KeyPressed && event.key.code == sf::Keyboard::F5) {
+                if (solver.saveCheckpoint(checkpointPath)) std::cout << "Saved " << checkpointPath << std::endl;
+            }
+            if (event.type == sf::Event::KeyPressed && event.key.code == sf::Keyboard::F9) {
+                if (solver.loadCheckpoint(checkpointPath)) std::cout << "Loaded " << checkpointPath << std::endl;
+            }
+
+            // start or stop recording the trajectory
+            if (event.type == sf::Event::KeyPressed && event.key.code == sf::Keyboard::F6) {
+                TrajectoryRecorder* recorder = solver.getRecorder();
+                if (!recorder->isRecording()) recorder->start(TRAJECTORY_PATH);
+                else {
+                    recorder->stop();
+                    std::cout << "Recorded " << recorder->getRecordedCount() << " frames to " << TRAJECTORY_PATH
+                              << ", dropped " << recorder->getDroppedCount() << std::endl;
+                }
+            }
+
             if (event.type == sf::Event::Resized)
             {
                 // don't stretch on window resize
@@ -60,29 +89,147 @@ void solverThread(Solver& solver, Renderer& renderer)
                 solver.getBounds()->right = int(event.size.width);
                 solver.getBounds()->down = int(event.size.height);
                 solver.getGrid()->setGridSize(int(event.size.width), int(event.size.height));
+                solver.wakeAll();
             }
         }
 
+        /*
+        The solver always advances by a fixed step of 1 / FRAMERATE, however long
+        the render frame took. Elapsed time is banked in the accumulator and paid
+        out in whole steps; after a long stall the backlog is dropped rather than
+        simulated, so one slow frame cannot snowball into slower ones.
+        */
+        float stepTime = 1.f / float(solver.getFramerate());
+        accumulator += frame.restart().asSeconds();
+
+        int steps = 0;
+        while (accumulator >= stepTime && steps < MAX_STEPS_PER_FRAME) {
+            solver.updateSolver(stepTime);
+            accumulator -= stepTime;
+            steps++;
+        }
+        if (steps == MAX_STEPS_PER_FRAME) accumulator = std::min(accumulator, stepTime);
+
+        // show the object count in the title, with how many are asleep and any recording in progress
+        if (infoUpdate.getElapsedTime().asSeconds() >= 0.5f) {
+            std::string title = "Simulation Window - " + std::to_string(solver.getObjectCount()) + " objects, "
+                                + std::to_string(solver.getAsleepCount()) + " asleep";
+            const TrajectoryRecorder* recorder = solver.getRecorder();
+            if (recorder->isRecording()) {
+                title += ", recording (" + std::to_string(recorder->getDroppedCount()) + " frames dropped)";
+            }
+            window.setTitle(title);
+            infoUpdate.restart();
+        }
+
         window.clear();
 
-        solver.updateSolver(frametime);
-        renderer.renderSolver(solver, window);
+        // draw the part of the next step that has already elapsed
+        renderer.renderSolver(solver, window, accumulator / stepTime);
 
         window.display();
+    }
+}
+
+/// <summary>
+/// Plays a recorded trajectory in a window, with no solver or control panel.
+/// Space pauses, the arrow keys seek and change speed, Home and End jump to either end.
+/// </summary>
+/// <param name="path"></param>
+/// <returns>The process exit code.</returns>
+int playbackWindow(const std::string& path)
+{
+    TrajectoryPlayer player;
+    std::string error;
+    if (!player.open(path, error)) {
+        std::cerr << error << std::endl;
+        return 1;
+    }
+
+    Renderer renderer = Renderer();
+    sf::RenderWindow window(sf::VideoMode(WINDOW_W, WINDOW_H), "Playback Window");
+    window.setFramerateLimit(RENDER_FRAMERATE);
+    bool sized = false;                 // the window takes the recorded bounds once the first frame is shown
+
+    sf::Clock frame;
+    sf::Clock infoUpdate;
+
+    while (window.isOpen()) {
+
+        sf::Event event;
+        while (window.pollEvent(event)) {
 
-        // get time since last frame and calculate framerate
-        frametime = frame.getElapsedTime().asSeconds();
-        framerate = int(std::round(1 / frametime));
-        frame.restart();
+            // close window on esc
+            if (event.type == sf::Event::Closed || ((event.type == sf::Event::KeyPressed) && (event.key.code == sf::Keyboard::Escape))) {
+                window.close();
+            }
+
+            if (event.type == sf::Event::KeyPressed) {
+                double seekFrames = SEEK_SECONDS / player.getFrameTime();
+                switch (event.key.code) {
+                case sf::Keyboard::Space: player.togglePause(); break;
+                case sf::Keyboard::Left: player.seek(player.getPosition() - seekFrames); break;
+                case sf::Keyboard::Right: player.seek(player.getPosition() + seekFrames); break;
+                case sf::Keyboard::Home: player.seek(double(player.getFirstFrame())); break;
+                case sf::Keyboard::End: player.seek(double(player.getLastFrame())); break;
+                case sf::Keyboard::Up: player.setSpeed(player.getSpeed() * 2.0); break;
+                case sf::Keyboard::Down: player.setSpeed(player.getSpeed() / 2.0); break;
+                default: break;
+                }
+            }
+
+            if (event.type == sf::Event::Resized)
+            {
+                // don't stretch on window resize
+                sf::FloatRect visibleArea(0, 0, float(event.size.width), float(event.size.height));
+                window.setView(sf::View(visibleArea));
+            }
+        }
+
+        player.advance(frame.restart().asSeconds());
+        if (player.hasFailed()) {
+            std::cerr << path << " is damaged" << std::endl;
+            return 1;
+        }
+
+        const RenderSnapshot& snapshot = player.getSnapshot();
+        if (!sized && snapshot.frame > 0) {
+            window.setSize(sf::Vector2u(unsigned(std::max(snapshot.bounds.right, 1)), unsigned(std::max(snapshot.bounds.down, 1))));
+            sized = true;
+        }
+
+        // show the playback position in the title
+        if (infoUpdate.getElapsedTime().asSeconds() >= 0.25f) {
+            std::string title = "Playback Window - frame " + std::to_string((long long)player.getPosition()) + " of "
+                                + std::to_string(player.getLastFrame()) + ", " + std::to_string(snapshot.size()) + " objects, ";
+            if (player.getSpeed() >= 1.0) title += "x" + std::to_string((long long)player.getSpeed());
+            else title += "x1/" + std::to_string((long long)std::lround(1.0 / player.getSpeed()));
+            if (player.isBuffering()) title += ", buffering";
+            else if (player.isPaused()) title += ", paused";
+            window.setTitle(title);
+            infoUpdate.restart();
+        }
+
+        window.clear();
+        renderer.renderSnapshot(snapshot, window, player.getAlpha());
+        window.display();
     }
+    return 0;
 }
 
 int main(int argc, char** argv)
 {
+    // playback needs neither a solver nor the control panel
+    if (argc > 2 && std::string(argv[1]) == "--play") return playbackWindow(argv[2]);
+
     Solver solver = Solver();
     Renderer renderer = Renderer();
 
-    std::thread th_solver = std::thread(solverThread, std::ref(solver), std::ref(renderer));
+    // an optional checkpoint to start from, loaded before the solver thread exists
+    std::string checkpointPath = argc > 1 ? argv[1] : DEFAULT_CHECKPOINT;
+    bool restored = argc > 1 && solver.loadCheckpoint(checkpointPath);
+
+    std::thread th_solver = std::thread(solverThread, std::ref(solver), std::ref(renderer), checkpointPath, restored);
     th_solver.detach();
 
     QApplication controlApp(argc, argv);
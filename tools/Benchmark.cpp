@@ -0,0 +1,405 @@
+/*
+====================================================================================
+Headless solver benchmark
+    Drives Solver::updateSolver with no window or control panel and reports
+    throughput for one or more named scenarios as CSV or JSON.
+
+    vv-bench [--scenario pile|jets|gas|mixed|all] [--broadphase grid|sweep|hash|all]
+             [--objects N] [--substeps N] [--adaptive MIN] [--sleep 0|1] [--grid incremental|full]
+             [--contacts sequential|jacobi] [--levels multi|single] [--reorder FRAMES] [--threads N]
+             [--frames N] [--warmup N] [--width PX] [--height PX] [--min-radius PX] [--max-radius PX]
+             [--seed N] [--load FILE] [--save FILE] [--record FILE] [--check-resume 0|1]
+             [--format csv|json] [--out FILE]
+
+    --load starts from a checkpoint written by Solver::saveCheckpoint instead of
+    a scenario. The checkpoint holds every solver setting, so only --broadphase,
+    --threads, --frames and --warmup still apply; it is reported as the
+    "checkpoint" scenario.
+
+    --check-resume 1 runs every scenario a second time, saving a checkpoint
+    halfway through the measured frames and finishing from it in a new solver,
+    and reports the state hash that run ends with. The exit status is 2 if it
+    differs from the uninterrupted run's.
+====================================================================================
+*/
+
+#include "Scenarios.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <cstdint>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+struct BenchmarkResult
+{
+    ScenarioConfig config;
+    int threads = 0;
+    int finalObjects = 0;
+    int finalAsleep = 0;
+    double seconds = 0.0;
+    double stepsPerSecond = 0.0;
+    double substepsPerSecond = 0.0;
+    double substepsMean = 0.0;          // substeps per frame, below --substeps only with --adaptive
+    double nsPerParticleSubstep = 0.0;
+    double frameMsMean = 0.0;
+    double frameMsP50 = 0.0;
+    double frameMsP90 = 0.0;
+    double frameMsP99 = 0.0;
+    double frameMsMax = 0.0;
+    long long pairTests = 0;
+    double migrationFraction = 0.0;     // mean share of objects changing grid cell per substep
+    int reorders = 0;                   // spatial reorders during the measured frames
+    int gridLevels = 0;
+    double phaseMsMean[PROFILE_PHASE_COUNT] = {};     // from Solver::getFrameStats, zero without VV_PROFILING
+    std::vector<double> collisionBusyMs;    // per worker, mean time spent in collision jobs per frame
+    double collisionImbalance = 0.0;        // busiest worker over the mean of all workers, 1 when even
+    std::uint64_t stateHash = 0;            // Solver::getStateHash after the last frame, equal for equal results
+    bool resumeChecked = false;
+    std::uint64_t resumedStateHash = 0;     // the same run saved halfway and resumed, see --check-resume
+};
+
+/// <summary>
+/// Value at the given quantile of an already sorted sample list, using nearest rank.
+/// </summary>
+static double percentile(const std::vector<double>& sorted, double quantile)
+{
+    if (sorted.empty()) return 0.0;
+    size_t rank = size_t(std::ceil(quantile * sorted.size()));
+    return sorted[std::min(sorted.size(), std::max<size_t>(rank, 1)) - 1];
+}
+
+/// <summary>
+/// Builds one scenario in a new solver, or loads a checkpoint into it.
+/// </summary>
+/// <param name="solver"></param>
+/// <param name="config">With a <c>loadPath</c>, an empty <c>broadphase</c> keeps the checkpoint's; filled in with what the checkpoint holds.</param>
+/// <returns>False if the checkpoint could not be loaded.</returns>
+static bool prepareSolver(Solver& solver, ScenarioConfig& config)
+{
+    if (config.loadPath.empty()) {
+        Scenarios::applyRadii(solver, config);
+        Scenarios::setup(solver, config);
+        return true;
+    }
+
+    if (!solver.loadCheckpoint(config.loadPath)) return false;
+    if (config.broadphase == "grid") solver.setBroadphase(BroadphaseKind::Grid);
+    else if (config.broadphase == "sweep") solver.setBroadphase(BroadphaseKind::Sweep);
+    else if (config.broadphase == "hash") solver.setBroadphase(BroadphaseKind::Hash);
+
+    // report what the checkpoint holds
+    if (config.broadphase.empty()) config.broadphase = solver.getBroadphaseName();
+    config.objects = solver.getObjectCount();
+    config.substeps = solver.getSubsteps();
+    config.jacobiContacts = solver.getJacobiContacts();
+    config.dt = 1.f / float(solver.getFramerate());
+    return true;
+}
+
+/// <summary>
+/// Runs a scenario again without timing it, saving a checkpoint halfway through the measured frames
+/// and finishing from that checkpoint in a new solver. A resumed run must end in the same state as
+/// an uninterrupted one.
+/// </summary>
+/// <param name="config"></param>
+/// <param name="hash">Set to the state hash the resumed run ends with.</param>
+/// <returns>False if the checkpoint could not be saved or loaded.</returns>
+static bool runResumed(ScenarioConfig config, std::uint64_t& hash)
+{
+    int threads = config.threads > 0 ? config.threads : int(std::thread::hardware_concurrency());
+    const int totalFrames = config.warmup + config.frames;
+    const int savedFrames = config.warmup + config.frames / 2;
+    const std::string path = (std::filesystem::temp_directory_path() / "vv-bench-resume.vvchk").string();
+
+    {
+        Solver solver(threads);
+        if (!prepareSolver(solver, config)) return false;
+        for (int frame = 0; frame < savedFrames; frame++) {
+            Scenarios::step(solver, config);
+            solver.updateSolver(config.dt);
+        }
+        if (!solver.saveCheckpoint(path)) return false;
+    }
+
+    // the checkpoint holds the broadphase that was running, so nothing is overridden on load
+    Solver solver(threads);
+    bool loaded = solver.loadCheckpoint(path);
+    std::remove(path.c_str());
+    if (!loaded) return false;
+    for (int frame = savedFrames; frame < totalFrames; frame++) {
+        Scenarios::step(solver, config);
+        solver.updateSolver(config.dt);
+    }
+    hash = solver.getStateHash();
+    return true;
+}
+
+/// <summary>
+/// Builds one scenario, or loads a checkpoint, runs its warm-up and measured frames, and summarises the frame times.
+/// </summary>
+/// <param name="config">With a <c>loadPath</c>, an empty <c>broadphase</c> keeps the checkpoint's.</param>
+/// <param name="result">Filled in when the run succeeds.</param>
+/// <returns>False if the checkpoint could not be loaded or saved.</returns>
+static bool runScenario(ScenarioConfig config, BenchmarkResult& result)
+{
+    int threads = config.threads > 0 ? config.threads : int(std::thread::hardware_concurrency());
+    Solver solver(threads);
+    if (!prepareSolver(solver, config)) return false;
+
+    for (int frame = 0; frame < config.warmup; frame++) {
+        Scenarios::step(solver, config);
+        solver.updateSolver(config.dt);
+    }
+
+    if (!config.recordPath.empty() && !solver.getRecorder()->start(config.recordPath)) return false;
+
+    std::vector<double> frameMs;
+    frameMs.reserve(config.frames);
+    int reordersBefore = solver.getReorderCount();
+    double particleSubsteps = 0.0;
+    long long substeps = 0;
+    double migration = 0.0;
+    long long pairTests = 0;
+
+    for (int frame = 0; frame < config.frames; frame++) {
+        Scenarios::step(solver, config);
+        int objects = solver.getObjectCount();
+
+        auto start = std::chrono::steady_clock::now();
+        solver.updateSolver(config.dt);
+        auto end = std::chrono::steady_clock::now();
+
+        frameMs.push_back(std::chrono::duration<double, std::milli>(end - start).count());
+        particleSubsteps += double(objects) * solver.getFrameSubsteps();
+        substeps += solver.getFrameSubsteps();
+        migration += solver.getMigrationFraction();
+        pairTests += solver.getPairTestCount();
+    }
+
+    if (!config.recordPath.empty()) {
+        TrajectoryRecorder* recorder = solver.getRecorder();
+        recorder->stop();
+        std::clog << "recorded " << recorder->getRecordedCount() << " frames to " << config.recordPath
+                  << ", dropped " << recorder->getDroppedCount() << std::endl;
+    }
+    if (!config.savePath.empty() && !solver.saveCheckpoint(config.savePath)) return false;
+
+    result.config = config;
+    result.threads = solver.getThreadCount();
+    result.finalObjects = solver.getObjectCount();
+    result.finalAsleep = solver.getAsleepCount();
+    for (double ms : frameMs) { result.seconds += ms / 1000.0; }
+    if (result.seconds > 0.0) {
+        result.stepsPerSecond = config.frames / result.seconds;
+        result.substepsPerSecond = double(substeps) / result.seconds;
+    }
+    result.substepsMean = double(substeps) / config.frames;
+    result.migrationFraction = migration / config.frames;
+    result.reorders = solver.getReorderCount() - reordersBefore;
+    result.gridLevels = solver.getGrid()->getLevelCount();
+    if (particleSubsteps > 0.0) result.nsPerParticleSubstep = result.seconds * 1e9 / particleSubsteps;
+
+    std::sort(frameMs.begin(), frameMs.end());
+    if (!frameMs.empty()) {
+        result.frameMsMean = result.seconds * 1000.0 / frameMs.size();
+        result.frameMsP50 = percentile(frameMs, 0.50);
+        result.frameMsP90 = percentile(frameMs, 0.90);
+        result.frameMsP99 = percentile(frameMs, 0.99);
+        result.frameMsMax = frameMs.back();
+    }
+    result.pairTests = config.frames > 0 ? pairTests / config.frames : 0;
+
+    FrameStats stats = solver.getFrameStats();
+    for (int phase = 0; phase < PROFILE_PHASE_COUNT; phase++) {
+        result.phaseMsMean[phase] = stats.phases[phase].meanMs;
+    }
+    double busySum = 0.0;
+    double busyMax = 0.0;
+    for (const PhaseStats& busy : stats.collisionBusy) {
+        result.collisionBusyMs.push_back(busy.meanMs);
+        busySum += busy.meanMs;
+        busyMax = std::max(busyMax, busy.meanMs);
+    }
+    if (busySum > 0.0) result.collisionImbalance = busyMax * result.collisionBusyMs.size() / busySum;
+    result.stateHash = solver.getStateHash();
+    return true;
+}
+
+/// <summary>
+/// Formats a state hash as 16 hex digits.
+/// </summary>
+static std::string hexHash(std::uint64_t hash)
+{
+    std::ostringstream text;
+    text << std::hex << std::setw(16) << std::setfill('0') << hash;
+    return text.str();
+}
+
+static void writeCsv(std::ostream& out, const std::vector<BenchmarkResult>& results)
+{
+    out << "scenario,objects,final_objects,final_asleep,substeps,substeps_mean,threads,frames,steps_per_s,substeps_per_s,"
+           "ns_per_particle_substep,frame_ms_mean,frame_ms_p50,frame_ms_p90,frame_ms_p99,frame_ms_max,"
+           "pair_tests_per_substep,migration_fraction,reorders,grid_levels,broadphase,narrow_phase,collision_imbalance,contacts,state_hash,"
+           "resumed_state_hash";
+    for (int phase = 0; phase < PROFILE_PHASE_COUNT; phase++) {
+        out << ",ms_" << Profiler::phaseName(ProfilePhase(phase));
+    }
+    out << '\n';
+    for (const BenchmarkResult& r : results) {
+        out << r.config.scenario << ',' << r.config.objects << ',' << r.finalObjects << ',' << r.finalAsleep << ','
+            << r.config.substeps << ',' << r.substepsMean << ',' << r.threads << ',' << r.config.frames << ','
+            << r.stepsPerSecond << ',' << r.substepsPerSecond << ',' << r.nsPerParticleSubstep << ','
+            << r.frameMsMean << ',' << r.frameMsP50 << ',' << r.frameMsP90 << ','
+            << r.frameMsP99 << ',' << r.frameMsMax << ',' << r.pairTests << ','
+            << r.migrationFraction << ',' << r.reorders << ',' << r.gridLevels << ',' << r.config.broadphase << ',' << NarrowPhase::instructionSet()
+            << ',' << r.collisionImbalance << ',' << (r.config.jacobiContacts ? "jacobi" : "sequential") << ',' << hexHash(r.stateHash)
+            << ',' << (r.resumeChecked ? hexHash(r.resumedStateHash) : "");
+        for (int phase = 0; phase < PROFILE_PHASE_COUNT; phase++) { out << ',' << r.phaseMsMean[phase]; }
+        out << '\n';
+    }
+}
+
+static void writeJson(std::ostream& out, const std::vector<BenchmarkResult>& results)
+{
+    out << "[\n";
+    for (size_t i = 0; i < results.size(); i++) {
+        const BenchmarkResult& r = results[i];
+        out << "  {\"scenario\": \"" << r.config.scenario << "\", \"objects\": " << r.config.objects
+            << ", \"final_objects\": " << r.finalObjects << ", \"final_asleep\": " << r.finalAsleep << ", \"substeps\": " << r.config.substeps
+            << ", \"substeps_mean\": " << r.substepsMean << ", \"threads\": " << r.threads << ", \"frames\": " << r.config.frames
+            << ", \"steps_per_s\": " << r.stepsPerSecond << ", \"substeps_per_s\": " << r.substepsPerSecond
+            << ", \"ns_per_particle_substep\": " << r.nsPerParticleSubstep
+            << ", \"frame_ms\": {\"mean\": " << r.frameMsMean << ", \"p50\": " << r.frameMsP50
+            << ", \"p90\": " << r.frameMsP90 << ", \"p99\": " << r.frameMsP99 << ", \"max\": " << r.frameMsMax << "}"
+            << ", \"pair_tests_per_substep\": " << r.pairTests
+            << ", \"migration_fraction\": " << r.migrationFraction << ", \"reorders\": " << r.reorders << ", \"grid_levels\": " << r.gridLevels << ", \"broadphase\": \"" << r.config.broadphase << "\""
+            << ", \"narrow_phase\": \"" << NarrowPhase::instructionSet() << "\", \"phase_ms_mean\": {";
+        for (int phase = 0; phase < PROFILE_PHASE_COUNT; phase++) {
+            out << (phase ? ", " : "") << '"' << Profiler::phaseName(ProfilePhase(phase)) << "\": " << r.phaseMsMean[phase];
+        }
+        out << "}, \"collision_busy_ms\": [";
+        for (size_t worker = 0; worker < r.collisionBusyMs.size(); worker++) {
+            out << (worker ? ", " : "") << r.collisionBusyMs[worker];
+        }
+        out << "], \"collision_imbalance\": " << r.collisionImbalance
+            << ", \"contacts\": \"" << (r.config.jacobiContacts ? "jacobi" : "sequential") << "\""
+            << ", \"state_hash\": \"" << hexHash(r.stateHash) << "\"";
+        if (r.resumeChecked) out << ", \"resumed_state_hash\": \"" << hexHash(r.resumedStateHash) << "\"";
+        out << "}" << (i + 1 < results.size() ? ",\n" : "\n");
+    }
+    out << "]\n";
+}
+
+static void printUsage()
+{
+    std::cerr << "usage: vv-bench [--scenario pile|jets|gas|mixed|all] [--broadphase grid|sweep|hash|all]\n"
+                 "                [--objects N] [--substeps N] [--adaptive MIN] [--sleep 0|1] [--grid incremental|full]\n"
+                 "                [--contacts sequential|jacobi] [--levels multi|single] [--reorder FRAMES] [--threads N]\n"
+                 "                [--frames N] [--warmup N] [--width PX] [--height PX] [--min-radius PX] [--max-radius PX]\n"
+                 "                [--seed N] [--load FILE] [--save FILE] [--record FILE] [--check-resume 0|1]\n"
+                 "                [--format csv|json] [--out FILE]\n";
+}
+
+int main(int argc, char** argv)
+{
+    ScenarioConfig config;
+    std::string scenario = "all";
+    std::string broadphase;             // empty = grid, or the checkpoint's with --load
+    std::string format = "csv";
+    std::string outPath;
+    bool checkResume = false;
+
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--help" || arg == "-h") { printUsage(); return 0; }
+        if (i + 1 >= argc) { printUsage(); return 1; }
+        std::string value = argv[++i];
+
+        if (arg == "--scenario")         scenario = value;
+        else if (arg == "--broadphase")  broadphase = value;
+        else if (arg == "--objects")     config.objects = std::atoi(value.c_str());
+        else if (arg == "--substeps")    config.substeps = std::max(1, std::atoi(value.c_str()));
+        else if (arg == "--adaptive")    { config.adaptive = true; config.minSubsteps = std::max(1, std::atoi(value.c_str())); }
+        else if (arg == "--sleep")       config.sleeping = std::atoi(value.c_str()) != 0;
+        else if (arg == "--contacts")    config.jacobiContacts = (value == "jacobi");
+        else if (arg == "--grid")        config.incrementalGrid = (value != "full");
+        else if (arg == "--levels")      config.multiLevelGrid = (value != "single");
+        else if (arg == "--reorder")     config.reorderInterval = std::max(0, std::atoi(value.c_str()));
+        else if (arg == "--threads")     config.threads = std::atoi(value.c_str());
+        else if (arg == "--frames")      config.frames = std::max(1, std::atoi(value.c_str()));
+        else if (arg == "--warmup")      config.warmup = std::max(0, std::atoi(value.c_str()));
+        else if (arg == "--width")       config.width = std::atoi(value.c_str());
+        else if (arg == "--height")      config.height = std::atoi(value.c_str());
+        else if (arg == "--min-radius")  config.minRadius = std::atoi(value.c_str());
+        else if (arg == "--max-radius")  config.maxRadius = std::atoi(value.c_str());
+        else if (arg == "--seed")        config.seed = unsigned(std::strtoul(value.c_str(), nullptr, 10));
+        else if (arg == "--load")        config.loadPath = value;
+        else if (arg == "--save")        config.savePath = value;
+        else if (arg == "--record")      config.recordPath = value;
+        else if (arg == "--check-resume") checkResume = std::atoi(value.c_str()) != 0;
+        else if (arg == "--format")      format = value;
+        else if (arg == "--out")         outPath = value;
+        else { std::cerr << "unknown option " << arg << "\n"; printUsage(); return 1; }
+    }
+
+    std::vector<std::string> scenarios;
+    if (!config.loadPath.empty()) scenarios.push_back("checkpoint");
+    else if (scenario == "all") scenarios = Scenarios::names();
+    else if (Scenarios::isValid(scenario)) scenarios.push_back(scenario);
+    else { std::cerr << "unknown scenario " << scenario << "\n"; return 1; }
+
+    std::vector<std::string> broadphases;
+    if (broadphase.empty()) broadphases.push_back(config.loadPath.empty() ? "grid" : "");
+    else if (broadphase == "all") broadphases = { "grid", "sweep", "hash" };
+    else if (broadphase == "grid" || broadphase == "sweep" || broadphase == "hash") broadphases.push_back(broadphase);
+    else { std::cerr << "unknown broadphase " << broadphase << "\n"; return 1; }
+
+    if (format != "csv" && format != "json") { std::cerr << "unknown format " << format << "\n"; return 1; }
+    if ((!config.savePath.empty() || !config.recordPath.empty()) && scenarios.size() * broadphases.size() > 1) {
+        std::cerr << "--save and --record need a single scenario and broadphase\n";
+        return 1;
+    }
+
+    std::vector<BenchmarkResult> results;
+    bool resumeMismatch = false;
+    for (const std::string& name : scenarios) {
+        for (const std::string& kind : broadphases) {
+            ScenarioConfig run = config;
+            run.scenario = name;
+            run.broadphase = kind;
+            if (run.loadPath.empty()) std::clog << "running " << name << " with " << kind << " broadphase (" << run.objects << " objects)" << std::endl;
+            else std::clog << "running " << run.loadPath << " with " << (kind.empty() ? "its own" : kind) << " broadphase" << std::endl;
+            BenchmarkResult result;
+            if (!runScenario(run, result)) return 1;
+            if (checkResume) {
+                if (!runResumed(run, result.resumedStateHash)) return 1;
+                result.resumeChecked = true;
+                if (result.resumedStateHash != result.stateHash) {
+                    std::cerr << name << " with " << result.config.broadphase << " broadphase ends in another state when saved and resumed\n";
+                    resumeMismatch = true;
+                }
+            }
+            results.push_back(result);
+        }
+    }
+
+    std::ofstream file;
+    if (!outPath.empty()) {
+        file.open(outPath);
+        if (!file) { std::cerr << "cannot open " << outPath << "\n"; return 1; }
+    }
+    std::ostream& out = outPath.empty() ? std::cout : file;
+
+    if (format == "json") writeJson(out, results);
+    else writeCsv(out, results);
+    return resumeMismatch ? 2 : 0;
+}
@@ -0,0 +1,160 @@
+#include "Scenarios.h"
+#include <algorithm>
+#include <cmath>
+#include <random>
+
+static const float JET_SPEED = 2000.f;     // px/s, matches the default Spawner velocity
+static const int JET_COUNT = 4;
+
+/// <summary>
+/// Names of all built-in scenarios:
+///     pile  - objects stacked on the floor under gravity
+///     jets  - four high-speed jets filling the bounds over the first half of the run
+///     gas   - objects spread uniformly with random velocities and no gravity
+///     mixed - a floor pile with a wide radius distribution
+/// </summary>
+std::vector<std::string> Scenarios::names() { return { "pile", "jets", "gas", "mixed" }; }
+
+/// <summary>
+/// Draws a float uniformly from [low, high) using 24 bits of raw engine output. The standard library's
+/// distributions differ between implementations, so a seed would otherwise give different objects on
+/// different platforms.
+/// </summary>
+/// <param name="rng"></param>
+/// <param name="low"></param>
+/// <param name="high"></param>
+static float uniform(std::mt19937& rng, float low, float high)
+{
+    return low + (high - low) * (float(rng() >> 8) * (1.f / 16777216.f));
+}
+
+bool Scenarios::isValid(const std::string& name)
+{
+    std::vector<std::string> all = names();
+    return std::find(all.begin(), all.end(), name) != all.end();
+}
+
+/// <summary>
+/// Sets a solver's radius range for a scenario. Called before <c>setup</c>, which places the
+/// objects by the maximum radius.
+/// </summary>
+/// <param name="solver"></param>
+/// <param name="config">Radii of 0 select the scenario default.</param>
+void Scenarios::applyRadii(Solver& solver, const ScenarioConfig& config)
+{
+    int minRadius = (config.scenario == "mixed") ? 2 : 10;
+    int maxRadius = 20;
+    if (config.minRadius > 0) minRadius = config.minRadius;
+    if (config.maxRadius > 0) maxRadius = config.maxRadius;
+
+    // widen first so neither setter clamps against the previous range
+    solver.setMinRadius(1);
+    solver.setMaxRadius(maxRadius);
+    solver.setMinRadius(minRadius);
+}
+
+/// <summary>
+/// Configures a freshly constructed solver and fills it with the scenario's initial objects.
+/// </summary>
+/// <param name="solver"></param>
+/// <param name="config"></param>
+void Scenarios::setup(Solver& solver, const ScenarioConfig& config)
+{
+    solver.autoSpawning = false;
+    solver.setSubsteps(config.substeps);
+    solver.setMinSubsteps(config.minSubsteps);
+    solver.setAdaptiveSubsteps(config.adaptive);
+    solver.setSleeping(config.sleeping);
+    solver.setJacobiContacts(config.jacobiContacts);
+    solver.setDeterministic(true);
+    solver.setSeed(config.seed);
+    solver.setReorderInterval(config.reorderInterval);
+    solver.setMaxObjects(config.objects);
+    solver.setBounds(RectBounds(0, config.width, 0, config.height));
+    solver.getGrid()->setGridSize(config.width, config.height);
+    solver.getGrid()->incremental = config.incrementalGrid;
+    solver.getGrid()->multiLevel = config.multiLevelGrid;
+    if (config.broadphase == "sweep") solver.setBroadphase(BroadphaseKind::Sweep);
+    else if (config.broadphase == "hash") solver.setBroadphase(BroadphaseKind::Hash);
+    else solver.setBroadphase(BroadphaseKind::Grid);
+    solver.setGravity(Vec2D(0.f, config.scenario == "gas" ? 0.f : config.gravity));
+
+    // every draw comes from the run's own engine, so runs on several threads at once do not interfere
+    std::mt19937 rng(config.seed);
+    const float maxRadius = float(solver.getMaxRadius());
+
+    if (config.scenario == "gas") {
+        for (int i = 0; i < config.objects; i++) {
+            Circle circle;
+            Circle::generateRandomObject(circle, solver.getMinRadius(), solver.getMaxRadius(), rng);
+            float x = uniform(rng, maxRadius, config.width - maxRadius);
+            float y = uniform(rng, maxRadius, config.height - maxRadius);
+            float vx = uniform(rng, -300.f, 300.f);
+            float vy = uniform(rng, -300.f, 300.f);
+            circle.pos = Vec2D(x, y);
+            circle.vel = Vec2D(vx, vy);
+            solver.addObject(circle);
+        }
+    }
+    else if (config.scenario == "pile" || config.scenario == "mixed") {
+        // hexagonal rows from the floor up, with a small random velocity so the pile does not stay a perfect lattice
+        float spacing = 2.f * maxRadius;
+        int columns = std::max(1, int((config.width - spacing) / spacing));
+        for (int i = 0; i < config.objects; i++) {
+            int row = i / columns;
+            int col = i % columns;
+            float x = maxRadius + col * spacing + (row % 2) * 0.5f * spacing;
+            float y = config.height - maxRadius - row * spacing * 0.866f;
+            Circle circle;
+            Circle::generateRandomObject(circle, solver.getMinRadius(), solver.getMaxRadius(), rng);
+            circle.pos = Vec2D(std::min(x, config.width - maxRadius), std::max(y, maxRadius));
+            float vx = uniform(rng, -10.f, 10.f);
+            float vy = uniform(rng, -10.f, 10.f);
+            circle.vel = Vec2D(vx, vy);
+            solver.addObject(circle);
+        }
+    }
+}
+
+/// <summary>
+/// Per-frame scenario input, called before each <c>Solver::updateSolver</c>. The jets scenario
+/// injects objects here so that the full object count is reached halfway through the run.
+/// </summary>
+/// <param name="solver"></param>
+/// <param name="config"></param>
+void Scenarios::step(Solver& solver, const ScenarioConfig& config)
+{
+    if (config.scenario != "jets") return;
+
+    int remaining = config.objects - solver.getObjectCount();
+    if (remaining <= 0) return;
+
+    int fillFrames = std::max(1, (config.warmup + config.frames) / 2);
+    int perJet = std::max(1, (config.objects + fillFrames * JET_COUNT - 1) / (fillFrames * JET_COUNT));
+
+    // seeded by the object count, so a run draws the same objects however it is scheduled
+    std::mt19937 rng(config.seed + unsigned(solver.getObjectCount()));
+    const float maxRadius = float(solver.getMaxRadius());
+    const float w = float(config.width);
+    const float h = float(config.height);
+    const float diagonal = JET_SPEED * 0.7071f;
+    const Vec2D origins[JET_COUNT] = { Vec2D(2.f * maxRadius, 0.25f * h), Vec2D(w - 2.f * maxRadius, 0.25f * h),
+                                       Vec2D(0.25f * w, 2.f * maxRadius), Vec2D(0.75f * w, 2.f * maxRadius) };
+    const Vec2D velocities[JET_COUNT] = { Vec2D(JET_SPEED, 0.f), Vec2D(-JET_SPEED, 0.f),
+                                          Vec2D(diagonal, diagonal), Vec2D(-diagonal, diagonal) };
+
+    for (int jet = 0; jet < JET_COUNT; jet++) {
+        Vec2D direction = velocities[jet];
+        direction.scale(1.f / JET_SPEED);
+        for (int k = 0; k < perJet && remaining > 0; k++, remaining--) {
+            // objects injected in the same frame are spaced out along the jet
+            Vec2D offset;
+            Vec2D::scale(offset, direction, k * 2.f * maxRadius);
+            Circle circle;
+            Circle::generateRandomObject(circle, solver.getMinRadius(), solver.getMaxRadius(), rng);
+            Vec2D::add(circle.pos, origins[jet], offset);
+            circle.vel = velocities[jet];
+            solver.addObject(circle);
+        }
+    }
+}
@@ -0,0 +1,49 @@
+#ifndef SCENARIOS_H
+#define SCENARIOS_H
+
+#include "../include/Solver.h"
+#include <string>
+#include <vector>
+
+/// <summary>
+/// Everything needed to build and drive one headless scene.
+/// </summary>
+struct ScenarioConfig
+{
+    std::string scenario = "pile";
+    std::string broadphase = "grid";   // grid, sweep or hash
+    int objects = 5000;
+    int substeps = 4;               // fixed count, or the upper bound with adaptive substeps
+    int minSubsteps = 1;
+    bool adaptive = false;
+    bool sleeping = false;
+    bool jacobiContacts = false;    // gather every contact of a substep before applying any
+    bool incrementalGrid = true;    // false rebuilds the grid every substep
+    bool multiLevelGrid = true;     // false keeps every object in one grid level sized for the maximum radius
+    int reorderInterval = 0;        // frames between spatial reorders, 0 = never
+    int threads = 0;                // 0 = one per hardware thread
+    int frames = 600;
+    int warmup = 60;
+    int width = 1400;               // bounds, in pixels
+    int height = 1000;
+    int minRadius = 0;              // 0 = scenario default
+    int maxRadius = 0;
+    float gravity = 3000.f;         // px/s^2, downwards; the gas scenario has none
+    float dt = 1.f / 60.f;          // seconds per frame
+    unsigned seed = 1;
+    std::string loadPath;           // checkpoint to start from instead of the scenario, empty = none
+    std::string savePath;           // checkpoint written after the last frame, empty = none
+    std::string recordPath;         // trajectory of the measured frames, empty = none
+};
+
+namespace Scenarios
+{
+    std::vector<std::string> names();
+    bool isValid(const std::string&);
+
+    void applyRadii(Solver&, const ScenarioConfig&);
+    void setup(Solver&, const ScenarioConfig&);
+    void step(Solver&, const ScenarioConfig&);
+}
+
+#endif
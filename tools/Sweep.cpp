@@ -0,0 +1,313 @@
+/*
+====================================================================================
+Headless parameter sweep
+    Runs every combination of the given parameter values as an independent
+    Solver, several at once, each for the same stretch of simulated time, and
+    writes one CSV row of metrics per run.
+
+    vv-sweep [--scenario pile|jets|gas|mixed] [--broadphase grid|sweep|hash]
+             [--objects LIST] [--substeps LIST] [--gravity LIST]
+             [--min-radius LIST] [--max-radius LIST] [--seconds S] [--fps N]
+             [--width PX] [--height PX] [--seed N] [--jobs N] [--out FILE]
+
+    A LIST is one or more comma-separated values, such as --substeps 2,4,8.
+    Each run has a single-threaded solver and --jobs of them run at once, one
+    per hardware thread by default, since independent solvers share no work
+    and scale better than one solver's worker pool. Runs are deterministic, so
+    a row comes out the same at any --jobs.
+====================================================================================
+*/
+
+#include "Scenarios.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+struct SweepResult
+{
+    ScenarioConfig config;
+    int finalObjects = 0;
+    double wallSeconds = 0.0;           // spent in Solver::updateSolver, excluding the measurements
+    double stepsPerSecond = 0.0;
+    double nsPerParticleSubstep = 0.0;
+    long long pairTests = 0;            // per substep, mean over the frames
+    double contactsMean = 0.0;          // overlapping pairs at the end of a frame
+    long long contactsMax = 0;
+    double penetrationMean = 0.0;       // px, mean overlap of the overlapping pairs
+    double penetrationMax = 0.0;        // px, deepest overlap at the end of any frame
+    double energyStart = 0.0;           // kinetic plus gravitational potential energy
+    double energyEnd = 0.0;
+    std::uint64_t stateHash = 0;
+};
+
+/// <summary>
+/// Parses a comma-separated list of numbers.
+/// </summary>
+/// <returns>False if the list is empty or holds something that is not a number.</returns>
+template <typename T>
+static bool parseList(const std::string& text, std::vector<T>& values)
+{
+    values.clear();
+    std::stringstream list(text);
+    std::string item;
+    while (std::getline(list, item, ',')) {
+        std::stringstream number(item);
+        T value;
+        if (!(number >> value) || !number.eof()) return false;
+        values.push_back(value);
+    }
+    return !values.empty();
+}
+
+/// <summary>
+/// Kinetic energy plus gravitational potential energy, taking the potential as zero at the wall gravity
+/// pulls towards, so a pile at rest has little and a closed run should keep roughly what it started with.
+/// </summary>
+static double totalEnergy(Solver& solver)
+{
+    const ParticleStore& objects = solver.getObjects();
+    Vec2D gravity = solver.getGravity();
+    const RectBounds& bounds = *solver.getBounds();
+    double floorX = gravity.x() > 0.f ? bounds.right : bounds.left;
+    double floorY = gravity.y() > 0.f ? bounds.down : bounds.up;
+
+    double energy = 0.0;
+    for (int i = 0; i < objects.size(); i++) {
+        double speedSq = double(objects.velX[i]) * objects.velX[i] + double(objects.velY[i]) * objects.velY[i];
+        double height = gravity.x() * (floorX - objects.posX[i]) + gravity.y() * (floorY - objects.posY[i]);
+        energy += objects.mass[i] * (0.5 * speedSq + height);
+    }
+    return energy;
+}
+
+/// <summary>
+/// Finds every overlapping pair with a broadphase of the run's own, so measuring leaves the solver's untouched.
+/// </summary>
+/// <param name="probe"></param>
+/// <param name="solver"></param>
+/// <param name="contacts">Set to the number of overlapping pairs.</param>
+/// <param name="depthSum">Set to the sum of their overlaps, in px.</param>
+/// <param name="depthMax">Set to the deepest overlap, in px.</param>
+static void measureContacts(HashBroadphase& probe, Solver& solver, long long& contacts, double& depthSum, double& depthMax)
+{
+    const ParticleStore& objects = solver.getObjects();
+    contacts = 0;
+    depthSum = 0.0;
+    depthMax = 0.0;
+
+    // objects may have been reordered since the last measurement
+    probe.reset();
+    probe.setRadiusRange(solver.getMinRadius(), solver.getMaxRadius());
+    probe.update(objects);
+    probe.forEachNearPair(objects, 0.f, [&](int i, int j) {
+        float dx = objects.posX[j] - objects.posX[i];
+        float dy = objects.posY[j] - objects.posY[i];
+        float reach = objects.radius[i] + objects.radius[j];
+        float distanceSq = dx * dx + dy * dy;
+        if (distanceSq >= reach * reach) return;
+
+        double depth = double(reach) - std::sqrt(double(distanceSq));
+        contacts++;
+        depthSum += depth;
+        depthMax = std::max(depthMax, depth);
+    });
+}
+
+/// <summary>
+/// Builds one scenario on a single-threaded solver and runs it for the configured frames, measuring
+/// after every frame.
+/// </summary>
+static void runSweep(const ScenarioConfig& config, SweepResult& result)
+{
+    Solver solver(1);
+    Scenarios::applyRadii(solver, config);
+    Scenarios::setup(solver, config);
+    HashBroadphase probe;
+
+    // report the radii the scenario settled on rather than 0 for its defaults
+    result.config = config;
+    result.config.minRadius = solver.getMinRadius();
+    result.config.maxRadius = solver.getMaxRadius();
+    result.energyStart = totalEnergy(solver);
+
+    double particleSubsteps = 0.0;
+    long long pairTests = 0;
+    long long contactSum = 0;
+    double depthSum = 0.0;
+
+    for (int frame = 0; frame < config.frames; frame++) {
+        Scenarios::step(solver, config);
+        int objects = solver.getObjectCount();
+
+        auto start = std::chrono::steady_clock::now();
+        solver.updateSolver(config.dt);
+        auto end = std::chrono::steady_clock::now();
+
+        result.wallSeconds += std::chrono::duration<double>(end - start).count();
+        particleSubsteps += double(objects) * solver.getFrameSubsteps();
+        pairTests += solver.getPairTestCount();
+
+        long long contacts;
+        double frameDepthSum, frameDepthMax;
+        measureContacts(probe, solver, contacts, frameDepthSum, frameDepthMax);
+        contactSum += contacts;
+        depthSum += frameDepthSum;
+        result.contactsMax = std::max(result.contactsMax, contacts);
+        result.penetrationMax = std::max(result.penetrationMax, frameDepthMax);
+    }
+
+    result.finalObjects = solver.getObjectCount();
+    if (result.wallSeconds > 0.0) result.stepsPerSecond = config.frames / result.wallSeconds;
+    if (particleSubsteps > 0.0) result.nsPerParticleSubstep = result.wallSeconds * 1e9 / particleSubsteps;
+    result.pairTests = pairTests / config.frames;
+    result.contactsMean = double(contactSum) / config.frames;
+    if (contactSum > 0) result.penetrationMean = depthSum / double(contactSum);
+    result.energyEnd = totalEnergy(solver);
+    result.stateHash = solver.getStateHash();
+}
+
+/// <summary>
+/// Formats a state hash as 16 hex digits.
+/// </summary>
+static std::string hexHash(std::uint64_t hash)
+{
+    std::ostringstream text;
+    text << std::hex << std::setw(16) << std::setfill('0') << hash;
+    return text.str();
+}
+
+static void writeCsv(std::ostream& out, const std::vector<SweepResult>& results)
+{
+    out << "run,scenario,broadphase,objects,substeps,gravity,min_radius,max_radius,frames,final_objects,wall_s,steps_per_s,"
+           "ns_per_particle_substep,pair_tests_per_substep,contacts_mean,contacts_max,penetration_mean,penetration_max,"
+           "energy_start,energy_end,energy_ratio,state_hash\n";
+    for (size_t run = 0; run < results.size(); run++) {
+        const SweepResult& r = results[run];
+        out << run << ',' << r.config.scenario << ',' << r.config.broadphase << ',' << r.config.objects << ','
+            << r.config.substeps << ',' << r.config.gravity << ',' << r.config.minRadius << ',' << r.config.maxRadius << ','
+            << r.config.frames << ',' << r.finalObjects << ',' << r.wallSeconds << ',' << r.stepsPerSecond << ','
+            << r.nsPerParticleSubstep << ',' << r.pairTests << ',' << r.contactsMean << ',' << r.contactsMax << ','
+            << r.penetrationMean << ',' << r.penetrationMax << ',' << r.energyStart << ',' << r.energyEnd << ','
+            << (r.energyStart != 0.0 ? r.energyEnd / r.energyStart : 0.0) << ',' << hexHash(r.stateHash) << '\n';
+    }
+}
+
+static void printUsage()
+{
+    std::cerr << "usage: vv-sweep [--scenario pile|jets|gas|mixed] [--broadphase grid|sweep|hash]\n"
+                 "                [--objects LIST] [--substeps LIST] [--gravity LIST]\n"
+                 "                [--min-radius LIST] [--max-radius LIST] [--seconds S] [--fps N]\n"
+                 "                [--width PX] [--height PX] [--seed N] [--jobs N] [--out FILE]\n"
+                 "       a LIST is one or more comma-separated values\n";
+}
+
+int main(int argc, char** argv)
+{
+    ScenarioConfig base;
+    base.warmup = 0;
+    base.threads = 1;
+    std::vector<int> objectCounts = { base.objects };
+    std::vector<int> substepCounts = { base.substeps };
+    std::vector<float> gravities = { base.gravity };
+    std::vector<int> minRadii = { 0 };  // 0 = scenario default
+    std::vector<int> maxRadii = { 0 };
+    double seconds = 10.0;
+    int fps = 60;
+    int jobs = 0;                       // 0 = one per hardware thread
+    std::string outPath;
+
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--help" || arg == "-h") { printUsage(); return 0; }
+        if (i + 1 >= argc) { printUsage(); return 1; }
+        std::string value = argv[++i];
+
+        bool valid = true;
+        if (arg == "--scenario")         base.scenario = value;
+        else if (arg == "--broadphase")  base.broadphase = value;
+        else if (arg == "--objects")     valid = parseList(value, objectCounts);
+        else if (arg == "--substeps")    valid = parseList(value, substepCounts);
+        else if (arg == "--gravity")     valid = parseList(value, gravities);
+        else if (arg == "--min-radius")  valid = parseList(value, minRadii);
+        else if (arg == "--max-radius")  valid = parseList(value, maxRadii);
+        else if (arg == "--seconds")     seconds = std::atof(value.c_str());
+        else if (arg == "--fps")         fps = std::max(1, std::atoi(value.c_str()));
+        else if (arg == "--width")       base.width = std::atoi(value.c_str());
+        else if (arg == "--height")      base.height = std::atoi(value.c_str());
+        else if (arg == "--seed")        base.seed = unsigned(std::strtoul(value.c_str(), nullptr, 10));
+        else if (arg == "--jobs")        jobs = std::atoi(value.c_str());
+        else if (arg == "--out")         outPath = value;
+        else { std::cerr << "unknown option " << arg << "\n"; printUsage(); return 1; }
+        if (!valid) { std::cerr << "bad list for " << arg << ": " << value << "\n"; return 1; }
+    }
+
+    if (!Scenarios::isValid(base.scenario)) { std::cerr << "unknown scenario " << base.scenario << "\n"; return 1; }
+    if (base.broadphase != "grid" && base.broadphase != "sweep" && base.broadphase != "hash") {
+        std::cerr << "unknown broadphase " << base.broadphase << "\n";
+        return 1;
+    }
+    base.dt = 1.f / float(fps);
+    base.frames = std::max(1, int(std::lround(seconds * fps)));
+
+    // every combination, the last parameter varying fastest
+    std::vector<ScenarioConfig> runs;
+    for (int objects : objectCounts) {
+        for (int substeps : substepCounts) {
+            for (float gravity : gravities) {
+                for (int minRadius : minRadii) {
+                    for (int maxRadius : maxRadii) {
+                        ScenarioConfig run = base;
+                        run.objects = std::max(0, objects);
+                        run.substeps = std::max(1, substeps);
+                        run.gravity = gravity;
+                        run.minRadius = minRadius;
+                        run.maxRadius = maxRadius;
+                        runs.push_back(run);
+                    }
+                }
+            }
+        }
+    }
+
+    std::ofstream file;
+    if (!outPath.empty()) {
+        file.open(outPath);
+        if (!file) { std::cerr << "cannot open " << outPath << "\n"; return 1; }
+    }
+    std::ostream& out = outPath.empty() ? std::cout : file;
+
+    if (jobs <= 0) jobs = int(std::max(1u, std::thread::hardware_concurrency()));
+    jobs = std::min(jobs, int(runs.size()));
+    std::clog << "sweeping " << runs.size() << " runs of " << base.frames << " frames on " << jobs << " threads" << std::endl;
+
+    // each thread takes the next run not yet started, so long runs do not hold up short ones
+    std::vector<SweepResult> results(runs.size());
+    std::atomic<int> nextRun(0);
+    std::atomic<int> finished(0);
+    std::mutex logMutex;
+    std::vector<std::thread> threads;
+    for (int job = 0; job < jobs; job++) {
+        threads.emplace_back([&]() {
+            for (int run = nextRun++; run < int(runs.size()); run = nextRun++) {
+                runSweep(runs[run], results[run]);
+                std::lock_guard<std::mutex> lock(logMutex);
+                std::clog << "finished run " << run << " (" << ++finished << " of " << runs.size() << ")" << std::endl;
+            }
+        });
+    }
+    for (std::thread& thread : threads) { thread.join(); }
+
+    writeCsv(out, results);
+    return 0;
+}